@@ -0,0 +1,115 @@
+#ifndef CANCELLATION_H
+#define CANCELLATION_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <limits>
+#include <cstdint>
+
+namespace tp
+{
+    namespace component
+    {
+        /**
+         * @brief Shared state of a cancellation token
+         * @brief    
+         */
+        struct CancellationState
+        {
+            static constexpr std::int64_t never = std::numeric_limits<std::int64_t>::max(); // No deadline /  
+
+            std::atomic<bool> isCancelled{ false };      // Set by cancel() /  cancel()
+            std::atomic<std::int64_t> deadline{ never }; // Steady clock time in ns, never if unset /     , never   
+        };
+    }
+
+    /**
+     * @brief Token that lets the pool drop queued tasks before they run
+     * @brief ,         
+     *
+     * Copies share one state, so a token kept by the caller cancels every
+     * task pushed with a copy of it. The token is checked when a worker
+     * takes the task: a cancelled or expired task is destroyed without
+     * being run, and the future of push() reports broken_promise. A task
+     * that has already started is not interrupted.
+     *
+     *    ,  ,  ,
+     *   ,    .  ,
+     *     :    
+     *   ,  future  push()  broken_promise.
+     *     .
+     *
+     * @example
+     * tp::CancellationToken token;
+     * token.cancelAfter(std::chrono::milliseconds(200)); // Stale after 200 ms /   200 
+     * pool.submit(token, handleRequest, request);
+     * token.cancel(); // The client went away /  
+     */
+    class CancellationToken
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        CancellationToken() : state(std::make_shared<component::CancellationState>()) {}
+
+        /**
+         * @brief Cancel all tasks that carry this token
+         * @brief   ,   
+         */
+        void cancel() { this->state->isCancelled.store(true, std::memory_order_release); }
+
+        /**
+         * @brief Cancel the tasks that have not started by a point in time
+         * @brief  ,      
+         *
+         * An earlier deadline set before stays in force.
+         *        .
+         */
+        void cancelAt(Clock::time_point time)
+        {
+            std::int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+            std::int64_t current = this->state->deadline.load(std::memory_order_relaxed);
+            while (ns < current && !this->state->deadline.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {
+            }
+        }
+
+        /**
+         * @brief Cancel the tasks that have not started after a delay
+         * @brief  ,     
+         */
+        template <typename Rep, typename Period>
+        void cancelAfter(const std::chrono::duration<Rep, Period>& delay)
+        {
+            this->cancelAt(Clock::now() + std::chrono::duration_cast<Clock::duration>(delay));
+        }
+
+        /**
+         * @brief Check if the token was cancelled or its deadline has passed
+         * @brief ,        
+         *
+         * The clock is read only when a deadline is set.
+         *  ,    .
+         */
+        bool isCancelled() const
+        {
+            if (this->state->isCancelled.load(std::memory_order_acquire))
+                return true;
+
+            std::int64_t deadline = this->state->deadline.load(std::memory_order_relaxed);
+            if (deadline == component::CancellationState::never)
+                return false;
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count() >= deadline;
+        }
+
+    private:
+        template <typename QueuePolicy>
+        friend class BasicThreadPool;
+
+        explicit CancellationToken(std::shared_ptr<component::CancellationState> state) : state(std::move(state)) {}
+
+        std::shared_ptr<component::CancellationState> state; // Shared state, never nullptr /  ,   nullptr
+    };
+}
+
+#endif // CANCELLATION_H
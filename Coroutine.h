@@ -0,0 +1,370 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include "ThreadPool.h"
+
+// Requires C++20 coroutines, the header is empty otherwise
+//   C++20,   
+#ifdef TP_HAS_COROUTINES
+
+#include <mutex>
+#include <utility>
+#include <optional>
+#include <exception>
+#include <type_traits>
+#include <condition_variable>
+
+namespace tp
+{
+    template <typename T = void>
+    class task;
+
+    namespace component
+    {
+        /**
+         * @brief Part of the task promise that does not depend on the result type
+         * @brief   task,     
+         *
+         * A task starts only when it is awaited. When its body finishes, the
+         * awaiting coroutine is resumed inline by symmetric transfer, so a
+         * chain of tasks needs neither a pool round trip nor extra stack.
+         *
+         *     .    ,
+         *       
+         * ,         , 
+         *  .
+         */
+        class TaskPromiseBase
+        {
+            struct FinalAwaiter
+            {
+                bool await_ready() const noexcept { return false; }
+
+                template <typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+                {
+                    std::coroutine_handle<> continuation = handle.promise().continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+        public:
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+
+            void unhandled_exception() noexcept { this->error = std::current_exception(); }
+
+            void setContinuation(std::coroutine_handle<> continuation) noexcept { this->continuation = continuation; }
+
+        protected:
+            void rethrowIfFailed() const
+            {
+                if (this->error)
+                    std::rethrow_exception(this->error);
+            }
+
+        private:
+            std::coroutine_handle<> continuation; // Coroutine awaiting the task / ,  
+            std::exception_ptr error;             // Exception of the body /  
+        };
+
+        /**
+         * @brief Promise of task<T> holding the result
+         * @brief  task<T>,  
+         */
+        template <typename T>
+        class TaskPromise : public TaskPromiseBase
+        {
+            static_assert(!std::is_reference<T>::value, "tp::task does not support reference results");
+
+        public:
+            task<T> get_return_object() noexcept;
+
+            template <typename U>
+            void return_value(U&& value) { this->value.emplace(std::forward<U>(value)); }
+
+            T result()
+            {
+                this->rethrowIfFailed();
+                return std::move(*this->value);
+            }
+
+        private:
+            std::optional<T> value; // Result of the body /  
+        };
+
+        template <>
+        class TaskPromise<void> : public TaskPromiseBase
+        {
+        public:
+            task<void> get_return_object() noexcept;
+
+            void return_void() noexcept {}
+
+            void result() { this->rethrowIfFailed(); }
+        };
+
+        /**
+         * @brief One-shot event for sync_wait()
+         * @brief    sync_wait()
+         */
+        class SyncEvent
+        {
+        public:
+            void set()
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->isSet = true;
+                this->cv.notify_all();
+            }
+
+            void wait()
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->cv.wait(lock, [this]() { return this->isSet; });
+            }
+
+        private:
+            std::mutex mutex;           // Protects isSet /  isSet
+            std::condition_variable cv; // Signalled by set() /  set()
+            bool isSet = false;         // Event has happened /  
+        };
+
+        /**
+         * @brief Coroutine that awaits a task and signals an event at the end
+         * @brief ,       
+         */
+        class SyncDriver
+        {
+        public:
+            struct promise_type
+            {
+                struct FinalAwaiter
+                {
+                    bool await_ready() const noexcept { return false; }
+
+                    // The frame is already suspended, so the waiter may destroy it right after set()
+                    //   ,        set()
+                    void await_suspend(std::coroutine_handle<promise_type> handle) const noexcept { handle.promise().event->set(); }
+
+                    void await_resume() const noexcept {}
+                };
+
+                SyncDriver get_return_object() noexcept { return SyncDriver(std::coroutine_handle<promise_type>::from_promise(*this)); }
+                std::suspend_always initial_suspend() const noexcept { return {}; }
+                FinalAwaiter final_suspend() const noexcept { return {}; }
+                void return_void() noexcept {}
+                void unhandled_exception() noexcept { std::terminate(); } // The driver body catches everything /    
+
+                SyncEvent* event = nullptr; // Event signalled at the end / ,   
+            };
+
+            SyncDriver(SyncDriver&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+            SyncDriver(const SyncDriver&) = delete;
+            SyncDriver& operator=(const SyncDriver&) = delete;
+            SyncDriver& operator=(SyncDriver&&) = delete;
+
+            ~SyncDriver()
+            {
+                if (this->handle)
+                    this->handle.destroy();
+            }
+
+            /**
+             * @brief Start the driver and block until it has finished
+             * @brief       
+             */
+            void run()
+            {
+                SyncEvent event;
+                this->handle.promise().event = &event;
+                this->handle.resume();
+                event.wait();
+            }
+
+        private:
+            explicit SyncDriver(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+            std::coroutine_handle<promise_type> handle; // Driver frame /  
+        };
+    }
+
+    /**
+     * @brief Lazy coroutine with a result of type T
+     * @brief      T
+     *
+     * The body starts when the task is awaited and runs on the awaiting
+     * thread until it awaits something else, for example pool.schedule().
+     * On completion the awaiting coroutine is resumed inline on the thread
+     * that finished the body. No std::future and no shared state are
+     * involved, the result lives in the coroutine frame owned by the task.
+     *
+     *          ,
+     *     - ,  pool.schedule(). 
+     *        ,
+     *  . std::future     ,
+     *     ,   .
+     *
+     * @tparam T Result type, may be void /  ,   void
+     *
+     * @example
+     * tp::task<int> answer(tp::ThreadPool& pool) {
+     *     co_await pool.schedule();
+     *     co_return 42;
+     * }
+     * tp::task<int> twice(tp::ThreadPool& pool) {
+     *     co_return 2 * co_await answer(pool);
+     * }
+     * int x = tp::sync_wait(twice(pool));
+     */
+    template <typename T>
+    class task
+    {
+    public:
+        using promise_type = component::TaskPromise<T>;
+
+        task(task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+        task& operator=(task&& other) noexcept
+        {
+            if (this != &other) {
+                this->reset();
+                this->handle = std::exchange(other.handle, nullptr);
+            }
+            return *this;
+        }
+
+        task(const task&) = delete;
+        task& operator=(const task&) = delete;
+
+        ~task() { this->reset(); }
+
+        /**
+         * @brief Check if the task owns a coroutine
+         * @brief ,    
+         */
+        bool valid() const noexcept { return static_cast<bool>(this->handle); }
+
+        /**
+         * @brief Check if the body has finished
+         * @brief ,   
+         */
+        bool isReady() const noexcept { return !this->handle || this->handle.done(); }
+
+        /**
+         * @brief Start the task and suspend the awaiting coroutine until it finishes
+         * @brief         
+         *
+         * @return Result of the body /  
+         * @throw The exception thrown by the body / ,  
+         */
+        auto operator co_await() & noexcept { return Awaiter{ this->handle }; }
+        auto operator co_await() && noexcept { return Awaiter{ this->handle }; }
+
+    private:
+        friend class component::TaskPromise<T>;
+
+        struct Awaiter
+        {
+            std::coroutine_handle<promise_type> handle; // Awaited task /  
+
+            bool await_ready() const noexcept { return this->handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                this->handle.promise().setContinuation(awaiting);
+                return this->handle;
+            }
+
+            T await_resume() { return this->handle.promise().result(); }
+        };
+
+        explicit task(std::coroutine_handle<promise_type> handle) noexcept : handle(handle) {}
+
+        void reset() noexcept
+        {
+            if (this->handle) {
+                this->handle.destroy();
+                this->handle = nullptr;
+            }
+        }
+
+        std::coroutine_handle<promise_type> handle; // Owned coroutine frame /  ,   
+    };
+
+    namespace component
+    {
+        template <typename T>
+        task<T> TaskPromise<T>::get_return_object() noexcept
+        {
+            return task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+        }
+
+        inline task<void> TaskPromise<void>::get_return_object() noexcept
+        {
+            return task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+        }
+
+        template <typename T>
+        SyncDriver syncWaitDriver(task<T>& work, std::optional<T>& result, std::exception_ptr& error)
+        {
+            try {
+                result.emplace(co_await work);
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+        }
+
+        inline SyncDriver syncWaitDriver(task<void>& work, std::exception_ptr& error)
+        {
+            try {
+                co_await work;
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+        }
+    }
+
+    /**
+     * @brief Run a task to completion from ordinary code
+     * @brief       
+     *
+     * Blocks the calling thread, so it must not be called on a worker of the
+     * pool the task resumes on.
+     *
+     *   ,      
+     *  ,    .
+     *
+     * @param work Task to run /   
+     * @return Result of the task /  
+     * @throw The exception thrown by the task / ,  
+     */
+    template <typename T>
+    T sync_wait(task<T> work)
+    {
+        std::optional<T> result;
+        std::exception_ptr error;
+        component::syncWaitDriver(work, result, error).run();
+
+        if (error)
+            std::rethrow_exception(error);
+        return std::move(*result);
+    }
+
+    inline void sync_wait(task<void> work)
+    {
+        std::exception_ptr error;
+        component::syncWaitDriver(work, error).run();
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+}
+
+#endif // TP_HAS_COROUTINES
+
+#endif // COROUTINE_H
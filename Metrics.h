@@ -0,0 +1,205 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Define TP_ENABLE_METRICS for every translation unit that includes the pool
+// to collect per-worker counters and latency histograms. Without it the
+// instrumentation is compiled out and stats() returns an empty snapshot.
+//
+//  TP_ENABLE_METRICS    ,  ,
+//       .  
+//     stats()   .
+
+namespace tp
+{
+    /**
+     * @brief Histogram of durations in nanoseconds with power-of-two buckets
+     * @brief        
+     *
+     * Bucket i counts durations in [2^i, 2^(i+1)) ns, bucket 0 also counts 0 ns
+     * and the last bucket counts everything above.
+     *
+     *  i    [2^i, 2^(i+1)) ,  0 
+     *  0 ,    - ,  .
+     */
+    struct Histogram
+    {
+        static constexpr size_t numBuckets = 40; // Up to ~18 minutes /  ~18 
+
+        std::array<std::uint64_t, numBuckets> buckets{}; // Counts per bucket /    
+
+        /**
+         * @brief Bucket index for a duration
+         * @brief    
+         */
+        static size_t bucketOf(std::uint64_t ns)
+        {
+            size_t bucket = 0;
+            while (ns > 1 && bucket < numBuckets - 1) {
+                ns >>= 1;
+                ++bucket;
+            }
+            return bucket;
+        }
+
+        /**
+         * @brief Upper bound of a bucket in nanoseconds
+         * @brief     
+         */
+        static std::uint64_t upperBound(size_t bucket) { return std::uint64_t(2) << bucket; }
+
+        /**
+         * @brief Total number of samples
+         * @brief   
+         */
+        std::uint64_t count() const
+        {
+            std::uint64_t total = 0;
+            for (std::uint64_t n : buckets)
+                total += n;
+            return total;
+        }
+
+        /**
+         * @brief Approximate percentile
+         * @brief  
+         *
+         * @param p Fraction in [0, 1], e.g. 0.99 /   [0, 1],  0.99
+         * @return Upper bound of the bucket holding the percentile, 0 if empty /     , 0  
+         */
+        std::uint64_t percentile(double p) const
+        {
+            std::uint64_t total = count();
+            if (total == 0)
+                return 0;
+
+            std::uint64_t rank = static_cast<std::uint64_t>(p * static_cast<double>(total - 1)) + 1;
+            std::uint64_t seen = 0;
+            for (size_t i = 0; i < numBuckets; ++i) {
+                seen += buckets[i];
+                if (seen >= rank)
+                    return upperBound(i);
+            }
+            return upperBound(numBuckets - 1);
+        }
+
+        Histogram& operator+=(const Histogram& other)
+        {
+            for (size_t i = 0; i < numBuckets; ++i)
+                buckets[i] += other.buckets[i];
+            return *this;
+        }
+    };
+
+    /**
+     * @brief Counters of one worker thread
+     * @brief    
+     */
+    struct WorkerStats
+    {
+        std::uint64_t tasksExecuted = 0; // Tasks run by the worker / ,  
+        std::uint64_t busyNs = 0;        // Time spent running tasks /   
+        std::uint64_t idleNs = 0;        // Time spent spinning or parked /    
+        std::uint64_t steals = 0;        // Tasks taken from other deques / ,    
+    };
+
+    /**
+     * @brief Snapshot returned by ThreadPool::stats()
+     * @brief ,  ThreadPool::stats()
+     */
+    struct PoolStats
+    {
+        bool isEnabled = false;          // Built with TP_ENABLE_METRICS /   TP_ENABLE_METRICS
+        size_t queueDepth = 0;           // Tasks waiting in queues and deques /     
+        std::vector<WorkerStats> workers; // Per-worker counters /   
+        Histogram waitTime;              // Enqueue to start latency /     
+        Histogram runTime;               // Task run duration /   
+    };
+
+    namespace component
+    {
+        /**
+         * @brief Monotonic clock in nanoseconds
+         * @brief    
+         */
+        inline std::uint64_t metricsNow()
+        {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        /**
+         * @brief Live counters of one worker
+         * @brief    
+         *
+         * Written only by the owning worker, so updates are plain relaxed
+         * stores without read-modify-write. Each instance sits on its own
+         * cache lines so workers never share them.
+         *
+         *   -,   - 
+         *  relaxed-   --.
+         *     -,     .
+         */
+        struct alignas(64) WorkerMetrics
+        {
+            WorkerMetrics()
+            {
+                for (size_t i = 0; i < Histogram::numBuckets; ++i) {
+                    waitTime[i].store(0, std::memory_order_relaxed);
+                    runTime[i].store(0, std::memory_order_relaxed);
+                }
+            }
+
+            static void add(std::atomic<std::uint64_t>& counter, std::uint64_t value)
+            {
+                counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief Record a task that has waited wait ns and ran for run ns
+             * @brief  ,  wait    run 
+             */
+            void recordTask(std::uint64_t wait, std::uint64_t run)
+            {
+                add(tasksExecuted, 1);
+                add(busyNs, run);
+                add(waitTime[Histogram::bucketOf(wait)], 1);
+                add(runTime[Histogram::bucketOf(run)], 1);
+            }
+
+            /**
+             * @brief Add this worker to a snapshot
+             * @brief     
+             */
+            void collect(PoolStats& stats) const
+            {
+                WorkerStats worker;
+                worker.tasksExecuted = tasksExecuted.load(std::memory_order_relaxed);
+                worker.busyNs = busyNs.load(std::memory_order_relaxed);
+                worker.idleNs = idleNs.load(std::memory_order_relaxed);
+                worker.steals = steals.load(std::memory_order_relaxed);
+                stats.workers.push_back(worker);
+
+                for (size_t i = 0; i < Histogram::numBuckets; ++i) {
+                    stats.waitTime.buckets[i] += waitTime[i].load(std::memory_order_relaxed);
+                    stats.runTime.buckets[i] += runTime[i].load(std::memory_order_relaxed);
+                }
+            }
+
+            std::atomic<std::uint64_t> tasksExecuted{ 0 };                 // Tasks run /  
+            std::atomic<std::uint64_t> busyNs{ 0 };                        // Running time /  
+            std::atomic<std::uint64_t> idleNs{ 0 };                        // Spinning and parked time /    
+            std::atomic<std::uint64_t> steals{ 0 };                        // Successful steals /  
+            std::atomic<std::uint64_t> waitTime[Histogram::numBuckets];    // Wait histogram /  
+            std::atomic<std::uint64_t> runTime[Histogram::numBuckets];     // Run histogram /  
+        };
+    }
+}
+
+#endif // METRICS_H
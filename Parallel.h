@@ -0,0 +1,300 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <exception>
+#include <future>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <condition_variable>
+#include "ThreadPool.h"
+
+namespace tp
+{
+    namespace component
+    {
+        /**
+         * @brief Completion state shared by all pieces of one parallel algorithm call
+         * @brief  ,        
+         *
+         * Lives on the stack of the calling thread, which does not return before
+         * every piece has finished.
+         *
+         *     ,   , 
+         *    .
+         */
+        class ParallelState
+        {
+        public:
+            /**
+             * @brief Register a piece that is handed to the pool
+             * @brief  ,  
+             */
+            void add() { this->pending.fetch_add(1, std::memory_order_relaxed); }
+
+            /**
+             * @brief Finish a piece the pool destroyed unrun and stop remaining chunks
+             * @brief  ,    ,    
+             */
+            void drop()
+            {
+                this->isDropped.store(true, std::memory_order_relaxed);
+                this->isFailed.store(true, std::memory_order_relaxed);
+                this->done();
+            }
+
+            /**
+             * @brief Mark a piece as finished
+             * @brief    
+             */
+            void done()
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                if (this->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    this->cv.notify_all();
+            }
+
+            /**
+             * @brief Store the first exception and stop remaining chunks
+             * @brief       
+             */
+            void fail(std::exception_ptr exception)
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                if (!this->error)
+                    this->error = exception;
+                this->isFailed.store(true, std::memory_order_relaxed);
+            }
+
+            bool failed() const { return this->isFailed.load(std::memory_order_relaxed); }
+
+            /**
+             * @brief Wait for all pieces, executing queued tasks meanwhile
+             * @brief        
+             *
+             * @param pool Pool the pieces were pushed to / ,     
+             * @throw The first exception thrown by a chunk /  ,  
+             * @throw std::future_error with broken_promise if the pool dropped a piece /    
+             */
+            template <typename QueuePolicy>
+            void wait(BasicThreadPool<QueuePolicy>& pool)
+            {
+                while (this->pending.load(std::memory_order_acquire) != 0) {
+                    if (!pool.runPendingTask()) {
+                        std::unique_lock<std::mutex> lock(this->mutex);
+                        this->cv.wait_for(lock, std::chrono::microseconds(100), [this]() {
+                            return this->pending.load(std::memory_order_acquire) == 0;
+                            });
+                    }
+                }
+
+                // The last done() may still hold the mutex
+                //  done()    
+                std::lock_guard<std::mutex> lock(this->mutex);
+                if (this->error)
+                    std::rethrow_exception(this->error);
+                if (this->isDropped.load(std::memory_order_relaxed))
+                    throw std::future_error(std::future_errc::broken_promise);
+            }
+
+        private:
+            std::atomic<size_t> pending{ 0 };       // Pieces handed to the pool / ,  
+            std::atomic<bool> isFailed{ false };    // A chunk has thrown /   
+            std::atomic<bool> isDropped{ false };   // The pool destroyed a piece unrun /     
+            std::exception_ptr error;               // First exception /  
+            std::mutex mutex;                       // Protects error and cv /  error  cv
+            std::condition_variable cv;             // Signalled by the last piece /   
+        };
+
+        /**
+         * @brief TaskTicket actions for a piece: an unrun piece stops the remaining chunks and makes wait() throw
+         * @brief  TaskTicket  :     ,  wait()  
+         */
+        struct ParallelActions
+        {
+            using Target = ParallelState*;
+
+            static void release(ParallelState* state) { state->done(); }
+            static void drop(ParallelState* state) { state->drop(); }
+        };
+
+        using ParallelTicket = TaskTicket<ParallelActions>;
+
+        /**
+         * @brief Default chunk size for a range of n elements
+         * @brief        n 
+         */
+        template <typename QueuePolicy, typename Index>
+        Index parallelGrain(BasicThreadPool<QueuePolicy>& pool, Index n)
+        {
+            Index pieces = static_cast<Index>(8 * (pool.size() + 1));
+            return std::max<Index>(1, n / pieces);
+        }
+
+        /**
+         * @brief Process a range with lazy binary splitting
+         * @brief      
+         *
+         * The range is consumed grain elements at a time. Whenever the pool has
+         * idle workers, the upper half of what is left is pushed as a new piece.
+         *
+         *     grain .    
+         *  ,       .
+         */
+        template <typename QueuePolicy, typename Index, typename Chunk>
+        void parallelRange(BasicThreadPool<QueuePolicy>& pool, ParallelState& state, Index first, Index last, Index grain, Chunk& chunk)
+        {
+            try {
+                while (last - first > grain && !state.failed()) {
+                    if (pool.numIdle() > 0) {
+                        Index middle = first + (last - first) / 2;
+                        state.add();
+                        pool.submit([ticket = ParallelTicket(&state), &pool, &state, middle, last, grain, &chunk](int) mutable {
+                            parallelRange(pool, state, middle, last, grain, chunk);
+                            ticket.release();
+                            });
+                        last = middle;
+                    }
+                    else {
+                        chunk(first, first + grain);
+                        first += grain;
+                    }
+                }
+
+                if (!state.failed())
+                    chunk(first, last);
+            }
+            catch (...) {
+                state.fail(std::current_exception());
+            }
+        }
+
+        /**
+         * @brief Run chunk over [first, last) on the pool and the calling thread
+         * @brief  chunk  [first, last)     
+         */
+        template <typename QueuePolicy, typename Index, typename Chunk>
+        void parallelRun(BasicThreadPool<QueuePolicy>& pool, Index first, Index last, Index grain, Chunk& chunk)
+        {
+            static_assert(std::is_integral<Index>::value, "Parallel algorithms require an integral index type");
+
+            if (!(first < last))
+                return;
+
+            if (grain <= 0)
+                grain = parallelGrain(pool, static_cast<Index>(last - first));
+
+            // Without running workers the caller does everything itself
+            //        
+            if (pool.isStopped() || pool.size() == 0) {
+                chunk(first, last);
+                return;
+            }
+
+            ParallelState state;
+            parallelRange(pool, state, first, last, grain, chunk);
+            state.wait(pool);
+        }
+    }
+
+    /**
+     * @brief Call body(i) for every i in [first, last) in parallel
+     * @brief   body(i)   i  [first, last)
+     *
+     * The calling thread takes part in the work and returns once every index
+     * has been processed.
+     *
+     *         
+     *  .
+     *
+     * @param pool Pool to run on /   
+     * @param first Beginning of the range /  
+     * @param last End of the range /  
+     * @param body Function called for each index / ,    
+     * @param grain Smallest chunk size, 0 to choose automatically /   , 0   
+     * @throw The first exception thrown by body /  ,  body
+     */
+    template <typename QueuePolicy, typename Index, typename Body>
+    void parallel_for(BasicThreadPool<QueuePolicy>& pool, Index first, Index last, Body body, Index grain = 0)
+    {
+        auto chunk = [&body](Index begin, Index end) {
+            for (Index i = begin; i < end; ++i)
+                body(i);
+        };
+        component::parallelRun(pool, first, last, grain, chunk);
+    }
+
+    /**
+     * @brief Reduce [first, last) in parallel from per-chunk results
+     * @brief   [first, last)   
+     *
+     * body(begin, end, acc) folds a chunk into acc and returns it, reduce
+     * combines chunk results. Like std::reduce, reduce must be associative
+     * and commutative because chunks finish in any order.
+     *
+     * body(begin, end, acc)    acc   ,
+     * reduce   .    std::reduce, reduce 
+     *    ,       .
+     *
+     * @param pool Pool to run on /   
+     * @param first Beginning of the range /  
+     * @param last End of the range /  
+     * @param identity Identity element of reduce /   reduce
+     * @param body Chunk function T(Index, Index, T) /   T(Index, Index, T)
+     * @param reduce Combining function T(T, T) /   T(T, T)
+     * @param grain Smallest chunk size, 0 to choose automatically /   , 0   
+     * @return Reduced value /  
+     */
+    template <typename QueuePolicy, typename Index, typename T, typename Body, typename Reduce>
+    T parallel_reduce(BasicThreadPool<QueuePolicy>& pool, Index first, Index last, T identity, Body body, Reduce reduce, Index grain = 0)
+    {
+        T result = identity;
+        std::mutex mutex;
+
+        auto chunk = [&](Index begin, Index end) {
+            T part = body(begin, end, identity);
+            std::lock_guard<std::mutex> lock(mutex);
+            result = reduce(std::move(result), std::move(part));
+        };
+        component::parallelRun(pool, first, last, grain, chunk);
+        return result;
+    }
+
+    /**
+     * @brief Transform every index and reduce the results in parallel
+     * @brief       
+     *
+     * @param pool Pool to run on /   
+     * @param first Beginning of the range /  
+     * @param last End of the range /  
+     * @param init Initial value, combined once /  ,   
+     * @param reduce Associative and commutative function T(T, T) /     T(T, T)
+     * @param transform Function called for each index / ,    
+     * @param grain Smallest chunk size, 0 to choose automatically /   , 0   
+     * @return Reduced value /  
+     */
+    template <typename QueuePolicy, typename Index, typename T, typename Reduce, typename Transform>
+    T parallel_transform_reduce(BasicThreadPool<QueuePolicy>& pool, Index first, Index last, T init, Reduce reduce, Transform transform, Index grain = 0)
+    {
+        T result = init;
+        std::mutex mutex;
+
+        // Each chunk starts from its own first element, so no identity is required
+        //       ,     
+        auto chunk = [&](Index begin, Index end) {
+            T part = transform(begin);
+            for (Index i = begin + 1; i < end; ++i)
+                part = reduce(std::move(part), transform(i));
+
+            std::lock_guard<std::mutex> lock(mutex);
+            result = reduce(std::move(result), std::move(part));
+        };
+        component::parallelRun(pool, first, last, grain, chunk);
+        return result;
+    }
+}
+
+#endif // PARALLEL_H
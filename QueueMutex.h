@@ -2,9 +2,15 @@
 #define QUEUE_MUTEX_H
 
 #include <queue>
+#include <vector>
+#include <algorithm>
 #include <mutex>
 #include <atomic>
 #include <functional>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include "TaskAllocator.h"
 
 namespace tp
 {
@@ -18,13 +24,89 @@ namespace tp
          * @tparam T  ,   
          */
         template <typename T>
-        class QueueMutex
+        class QueueMutex : public CacheAligned
         {
         public:
-            virtual bool push(T const& value) = 0;
+            virtual bool push(T&& value) = 0;
             virtual bool pop(T& value) = 0;
             virtual bool empty() = 0;
             virtual ~QueueMutex() = default;
+
+            /**
+             * @brief Push an element with a priority
+             * @brief    
+             *
+             * Queues without priorities ignore it.
+             *     .
+             *
+             * @param value Element to push /   
+             * @param priority Priority (higher = more important) /  ( = )
+             * @return true if successful / true   
+             */
+            virtual bool push(T&& value, int priority)
+            {
+                (void)priority;
+                return this->push(std::move(value));
+            }
+
+            /**
+             * @brief Check if the queue orders elements by priority
+             * @brief ,      
+             *
+             * The pool never lets tasks bypass such a queue.
+             *        .
+             */
+            virtual bool hasPriorities() const { return false; }
+
+            /**
+             * @brief Push several elements at once
+             * @brief      
+             *
+             * @param values Elements to push, moved from on success /   ,   
+             * @param count Number of elements /  
+             * @return Number of elements pushed from the front of values /      values
+             */
+            virtual size_t pushBulk(T* values, size_t count)
+            {
+                size_t i = 0;
+                while (i < count && this->push(std::move(values[i])))
+                    ++i;
+                return i;
+            }
+
+            /**
+             * @brief Pop up to maxN elements at once
+             * @brief   maxN    
+             *
+             * Elements come out in the order single pops would return them.
+             *      ,    pop.
+             *
+             * @param out Storage for at least maxN elements /     maxN 
+             * @param maxN Maximum number of elements /   
+             * @return Number of elements written to the front of out /  ,    out
+             */
+            virtual size_t popBatch(T* out, size_t maxN)
+            {
+                size_t i = 0;
+                while (i < maxN && this->pop(out[i]))
+                    ++i;
+                return i;
+            }
+
+            /**
+             * @brief Remove the element a full queue gives up first
+             * @brief  ,     
+             *
+             * FIFO queues give up the oldest element, that is the one pop() would return.
+             *  FIFO    ,   ,    pop().
+             *
+             * @param value Reference to store the removed element /     
+             * @return true if an element was removed, false if the queue is empty / true   , false   
+             */
+            virtual bool evict(T& value)
+            {
+                return this->pop(value);
+            }
         };
 
         /**
@@ -35,24 +117,69 @@ namespace tp
          * @tparam T  ,   
          */
         template <typename T>
-        class NormalQueue : public QueueMutex<T>
+        class NormalQueue final : public QueueMutex<T>
         {
         public:
+            using QueueMutex<T>::push;
+
+            /**
+             * @brief Constructor
+             * @brief 
+             *
+             * Elements are kept in a ring of slots. A bounded queue allocates
+             * all of them up front, so a full queue under steady load never
+             * allocates. An unbounded queue doubles the ring when it runs out
+             * of slots and gives large rings back once it is empty.
+             *
+             *     .   
+             *   ,     
+             *     .  
+             *  ,   ,  
+             *  ,  .
+             *
+             * @param capacity Maximum number of elements, 0 for unbounded /   , 0  
+             */
+            explicit NormalQueue(size_t capacity = 0) : capacity(capacity)
+            {
+                if (capacity > 0)
+                    this->ring.resize(capacity);
+            }
+
             /**
              * @brief Push an element to the thread-safe queue
              * @brief     
              *
              * @param value Element to push /   
-             * @return true if successful / true   
+             * @return true if successful, false if the queue is full (value is left untouched) / true   , false    (  )
              */
-            bool push(T const& value) override
+            bool push(T&& value) override
             {
                 // Lock mutex for thread-safe operation
                 //     
                 std::unique_lock<std::mutex> lock(this->mutex);
-                this->queue.push(value);
+                if (this->reserve(1) == 0)
+                    return false;
+                this->ring[this->index(this->count++)] = std::move(value);
                 return true;
             };
+
+            /**
+             * @brief Push several elements under a single lock
+             * @brief      
+             *
+             * @param values Elements to push /   
+             * @param count Number of elements /  
+             * @return Number of elements pushed from the front of values /      values
+             */
+            size_t pushBulk(T* values, size_t count) override
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                size_t pushed = this->reserve(count);
+                for (size_t i = 0; i < pushed; ++i)
+                    this->ring[this->index(this->count++)] = std::move(values[i]);
+                return pushed;
+            }
+
             /**
              * @brief Pop an element from the thread-safe queue
              * @brief     
@@ -68,14 +195,32 @@ namespace tp
 
                 // Check if queue is empty before popping
                 //     
-                if (this->queue.empty())
+                if (this->count == 0)
                     return false;
 
-                value = this->queue.front();
-                this->queue.pop();
+                value = std::move(this->ring[this->head]);
+                this->advance(1);
                 return true;
             };
 
+            /**
+             * @brief Pop up to maxN elements under a single lock
+             * @brief   maxN    
+             *
+             * @param out Storage for at least maxN elements /     maxN 
+             * @param maxN Maximum number of elements /   
+             * @return Number of elements popped /   
+             */
+            size_t popBatch(T* out, size_t maxN) override
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                size_t count = std::min(maxN, this->count);
+                for (size_t i = 0; i < count; ++i)
+                    out[i] = std::move(this->ring[this->index(i)]);
+                this->advance(count);
+                return count;
+            }
+
             /**
              * @brief Check if the queue is empty
              * @brief ,   
@@ -87,13 +232,80 @@ namespace tp
                 // Lock mutex for thread-safe check
                 //     
                 std::unique_lock<std::mutex> lock(this->mutex);
-                return this->queue.empty();
+                return this->count == 0;
             }
 
         private:
-            std::queue<T> queue;      // Internal queue storage /   
-            std::mutex mutex;         // Mutex for thread synchronization /    
+            static constexpr size_t minRing = 64;      // First ring of an unbounded queue /    
+            static constexpr size_t keptRing = 4096;   // Largest ring an empty unbounded queue keeps /  ,    
+
+            /**
+             * @brief Slot of the element at a distance from the head, mutex must be held
+             * @brief      ,    
+             */
+            size_t index(size_t offset) const
+            {
+                size_t pos = this->head + offset;
+                return pos < this->ring.size() ? pos : pos - this->ring.size();
+            }
+
+            /**
+             * @brief Make room for up to wanted elements, mutex must be held
+             * @brief       wanted ,    
+             *
+             * @return Number of elements that fit /   
+             */
+            size_t reserve(size_t wanted)
+            {
+                if (this->capacity > 0)
+                    return std::min(wanted, this->capacity - this->count);
+                if (this->count + wanted <= this->ring.size())
+                    return wanted;
+
+                // Elements move to the front of the new ring in queue order
+                //         
+                size_t size = std::max(this->ring.size() * 2, minRing);
+                while (size < this->count + wanted)
+                    size *= 2;
+                std::vector<T> grown(size);
+                for (size_t i = 0; i < this->count; ++i)
+                    grown[i] = std::move(this->ring[this->index(i)]);
+                this->ring.swap(grown);
+                this->head = 0;
+                return wanted;
+            }
+
+            /**
+             * @brief Drop count elements from the head, mutex must be held
+             * @brief  count   ,    
+             */
+            void advance(size_t count)
+            {
+                this->head = this->index(count);
+                this->count -= count;
+                if (this->count == 0 && this->capacity == 0 && this->ring.size() > keptRing) {
+                    std::vector<T>().swap(this->ring);
+                    this->head = 0;
+                }
+            }
+
+            // The lock holder touches all of them, the vtable pointer read by every caller stays on another line
+            //     ,  vtable,  ,    
+            alignas(64) std::mutex mutex; // Mutex for thread synchronization /    
+            std::vector<T> ring;          // Slots of the ring /  
+            size_t head = 0;              // Slot of the oldest element /    
+            size_t count = 0;             // Number of elements /  
+            size_t capacity;              // Maximum number of elements, 0 for unbounded /   , 0  
         };
+
+        // Definitions for C++14, std::max() takes the constants by reference
+        //   C++14, std::max()    
+        template <typename T>
+        constexpr size_t NormalQueue<T>::minRing;
+
+        template <typename T>
+        constexpr size_t NormalQueue<T>::keptRing;
+
         /**
          * @brief Structure for prioritized tasks with comparison operator
          * @brief       
@@ -102,7 +314,7 @@ namespace tp
         struct PrioritizedTask {
             T function;                            // Task function /  
             int priority;                          // Task priority (higher = more important) /   ( = )
-            uint32_t sequence;                     // Sequence number for FIFO within same priority /    FIFO    
+            uint64_t sequence;                     // Sequence number for FIFO within same priority /    FIFO    
 
             /**
              * @brief Comparison operator for priority queue ordering
@@ -118,64 +330,95 @@ namespace tp
                     return priority < other.priority; // Lower priority value = higher priority
                 }
 
-                // For same priority, handle sequence wrap-around
-                //      
-                uint32_t diff = sequence - other.sequence;
-
-                // If the difference is large (wrap-around occurred), reverse the order
-                //    ( ),  
-                if (diff > 0x80000000) {
-                    return sequence > other.sequence; // Older task (wrap-around) comes first
-                }
-                else {
-                    return sequence < other.sequence; // Normal FIFO order
-                }
+                // For same priority the older task comes first; a 64-bit counter does not wrap in practice
+                //        ; 64-     
+                return sequence > other.sequence;
             }
         };
 
         template <typename T>
-        class PriorityQueue : public QueueMutex<T>
+        class PriorityQueue final : public QueueMutex<T>
         {
         public:
+            /**
+             * @brief Constructor
+             * @brief 
+             *
+             * A bounded queue reserves its whole heap up front.
+             *      .
+             *
+             * @param capacity Maximum number of tasks, 0 for unbounded /   , 0  
+             */
+            explicit PriorityQueue(size_t capacity = 0) : capacity(capacity)
+            {
+                if (capacity > 0)
+                    this->queue.reserve(capacity);
+            }
+
             /**
              * @brief Push a task to the priority queue
              * @brief      
              *
-             * @param value Function pointer to push /     
+             * @param value Task to push /   
              * @return true if successful / true   
              */
-            bool push(T const& value) override
+            bool push(T&& value) override
             {
                 // Default priority is 0 (normal)
                 //    - 0 ()
-                return this->push(value, 0);
+                return this->push(std::move(value), 0);
             };
+
+            bool hasPriorities() const override { return true; }
+
+            /**
+             * @brief Push several tasks with default priority under a single lock
+             * @brief          
+             *
+             * @param values Tasks to push /   
+             * @param count Number of tasks /  
+             * @return Number of tasks pushed /   
+             */
+            size_t pushBulk(T* values, size_t count) override
+            {
+                return this->pushBulk(values, count, 0);
+            }
+
+            /**
+             * @brief Push several tasks with specific priority under a single lock
+             * @brief         
+             *
+             * @param values Tasks to push /   
+             * @param count Number of tasks /  
+             * @param priority Priority of all tasks /   
+             * @return Number of tasks pushed from the front of values /      values
+             */
+            size_t pushBulk(T* values, size_t count, int priority)
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                if (this->capacity > 0)
+                    count = std::min(count, this->capacity - this->queue.size());
+                for (size_t i = 0; i < count; ++i)
+                    this->pushLocked(std::move(values[i]), priority);
+                return count;
+            }
             
             /**
              * @brief Push a task with specific priority to the queue
              * @brief       
              *
-             * @param value Function pointer to push /     
+             * @param value Task to push /   
              * @param priority Task priority (higher = more important) /   ( = )
-             * @return true if successful / true   
+             * @return true if successful, false if the queue is full (value is left untouched) / true   , false    (  )
              */
-            bool push(T value, int priority)
+            bool push(T&& value, int priority) override
             {
                 // Lock mutex for thread-safe operation
                 //     
                 std::unique_lock<std::mutex> lock(this->mutex);
-
-                // Create prioritized task with sequence number
-                //       
-                PrioritizedTask<T> task;
-                task.function = value;
-                task.priority = priority;
-                task.sequence = nextSequence.fetch_add(1, std::memory_order_relaxed);
-                if (task.sequence == UINT32_MAX) {
-                    nextSequence.store(0, std::memory_order_relaxed);
-                }
-
-                this->queue.push(task);
+                if (this->capacity > 0 && this->queue.size() >= this->capacity)
+                    return false;
+                this->pushLocked(std::move(value), priority);
                 return true;
             };
 
@@ -183,10 +426,10 @@ namespace tp
              * @brief Pop the highest priority task from the queue
              * @brief       
              *
-             * @param value Reference to store popped task function /      
+             * @param value Reference to store popped task /     
              * @return true if task was popped, false if queue is empty / true   , false   
              */
-            bool pop(std::function<void(int id)>*& value) override
+            bool pop(T& value) override
             {
                 // Lock mutex for thread-safe operation
                 //     
@@ -199,12 +442,32 @@ namespace tp
 
                 // Get the highest priority task
                 //     
-                PrioritizedTask<T> task = this->queue.top();
-                value = task.function;
-                this->queue.pop();
+                std::pop_heap(this->queue.begin(), this->queue.end());
+                value = std::move(this->queue.back().function);
+                this->queue.pop_back();
                 return true;
             };
 
+            /**
+             * @brief Pop up to maxN highest priority tasks under a single lock
+             * @brief   maxN       
+             *
+             * @param out Storage for at least maxN tasks /     maxN 
+             * @param maxN Maximum number of tasks /   
+             * @return Number of tasks popped /   
+             */
+            size_t popBatch(T* out, size_t maxN) override
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                size_t count = std::min(maxN, this->queue.size());
+                for (size_t i = 0; i < count; ++i) {
+                    std::pop_heap(this->queue.begin(), this->queue.end());
+                    out[i] = std::move(this->queue.back().function);
+                    this->queue.pop_back();
+                }
+                return count;
+            }
+
             /**
              * @brief Check if the queue is empty
              * @brief ,   
@@ -219,10 +482,403 @@ namespace tp
                 return this->queue.empty();
             }
 
+            /**
+             * @brief Remove the oldest task of the lowest priority
+             * @brief       
+             *
+             * That task would be run last but for the ones pushed after it.
+             * Linear in the number of queued tasks.
+             *
+             *     ,    
+             * .      .
+             *
+             * @param value Reference to store the removed task /     
+             * @return true if a task was removed, false if the queue is empty / true   , false   
+             */
+            bool evict(T& value) override
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                if (this->queue.empty())
+                    return false;
+
+                auto victim = std::min_element(this->queue.begin(), this->queue.end(),
+                    [](const PrioritizedTask<T>& a, const PrioritizedTask<T>& b) {
+                        return a.priority != b.priority ? a.priority < b.priority : a.sequence < b.sequence;
+                    });
+                value = std::move(victim->function);
+                *victim = std::move(this->queue.back());
+                this->queue.pop_back();
+                std::make_heap(this->queue.begin(), this->queue.end());
+                return true;
+            }
+
         private:
-            std::priority_queue<PrioritizedTask<T>> queue; // Internal priority queue storage /     
-            std::mutex mutex;                           // Mutex for thread synchronization /    
-            std::atomic<uint32_t> nextSequence{ 0 };      // Sequence counter for FIFO ordering /    FIFO 
+            /**
+             * @brief Insert a task into the heap, mutex must be held
+             * @brief    ,    
+             */
+            void pushLocked(T&& value, int priority)
+            {
+                // Create prioritized task with sequence number
+                //       
+                PrioritizedTask<T> task;
+                task.function = std::move(value);
+                task.priority = priority;
+                task.sequence = this->nextSequence++;
+
+                // Binary heap on a vector so the top element can be moved out
+                //    ,      
+                this->queue.push_back(std::move(task));
+                std::push_heap(this->queue.begin(), this->queue.end());
+            }
+
+            // Same layout as NormalQueue: everything the lock holder writes starts a new line
+            //   ,    NormalQueue: ,    ,    
+            alignas(64) std::mutex mutex;               // Mutex for thread synchronization /    
+            std::vector<PrioritizedTask<T>> queue;       // Binary heap storage /   
+            uint64_t nextSequence = 0;                  // Sequence counter for FIFO ordering, guarded by mutex /    FIFO,  
+            size_t capacity;                            // Maximum number of tasks, 0 for unbounded /   , 0  
+        };
+
+        /**
+         * @brief Bounded lock-free multi-producer/multi-consumer ring buffer (Vyukov)
+         * @brief          ()
+         *
+         * Every slot carries a sequence counter that tells producers and consumers
+         * whether the slot is free or filled for the current lap, so neither
+         * push nor pop takes a lock or allocates memory.
+         *
+         *     ,  
+         *    ,     
+         * ,  push  pop       .
+         *
+         * @tparam T Type of elements stored in the queue
+         * @tparam T  ,   
+         */
+        template <typename T>
+        class RingQueue final : public QueueMutex<T>
+        {
+        public:
+            using QueueMutex<T>::push;
+
+            /**
+             * @brief Constructor
+             * @brief 
+             *
+             * @param capacity Maximum number of elements, rounded up to a power of two /   ,    
+             */
+            explicit RingQueue(size_t capacity = 65536)
+            {
+                size_t size = 2;
+                while (size < capacity)
+                    size <<= 1;
+
+                this->mask = size - 1;
+                this->buffer.reset(new Cell[size]);
+                for (size_t i = 0; i < size; ++i)
+                    this->buffer[i].sequence.store(i, std::memory_order_relaxed);
+
+                this->enqueuePos.store(0, std::memory_order_relaxed);
+                this->dequeuePos.store(0, std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief Push an element to the ring
+             * @brief     
+             *
+             * @param value Element to push /   
+             * @return true if successful, false if the ring is full (value is left untouched) / true   , false    (  )
+             */
+            bool push(T&& value) override
+            {
+                Cell* cell;
+                size_t pos = this->enqueuePos.load(std::memory_order_relaxed);
+
+                while (true) {
+                    cell = &this->buffer[pos & this->mask];
+                    size_t seq = cell->sequence.load(std::memory_order_acquire);
+                    intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+                    if (dif == 0) {
+                        // Slot is free for this lap - try to claim it
+                        //      -   
+                        if (this->enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                            break;
+                    }
+                    else if (dif < 0) {
+                        return false; // Ring is full /  
+                    }
+                    else {
+                        pos = this->enqueuePos.load(std::memory_order_relaxed);
+                    }
+                }
+
+                cell->data = std::move(value);
+                cell->sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            };
+
+            /**
+             * @brief Pop an element from the ring
+             * @brief     
+             *
+             * @param value Reference to store popped element /     
+             * @return true if element was popped, false if ring is empty / true   , false   
+             */
+            bool pop(T& value) override
+            {
+                Cell* cell;
+                size_t pos = this->dequeuePos.load(std::memory_order_relaxed);
+
+                while (true) {
+                    cell = &this->buffer[pos & this->mask];
+                    size_t seq = cell->sequence.load(std::memory_order_acquire);
+                    intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+
+                    if (dif == 0) {
+                        // Slot is filled for this lap - try to claim it
+                        //      -   
+                        if (this->dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                            break;
+                    }
+                    else if (dif < 0) {
+                        return false; // Ring is empty /  
+                    }
+                    else {
+                        pos = this->dequeuePos.load(std::memory_order_relaxed);
+                    }
+                }
+
+                value = std::move(cell->data);
+                cell->sequence.store(pos + this->mask + 1, std::memory_order_release);
+                return true;
+            };
+
+            /**
+             * @brief Pop up to maxN elements with a single claim
+             * @brief   maxN   
+             *
+             * The consumer counts the filled cells after its position and
+             * claims all of them with one compare-exchange, so a batch costs one
+             * contended operation instead of one per element.
+             *
+             *        
+             *     compare-exchange,   
+             *       .
+             *
+             * @param out Storage for at least maxN elements /     maxN 
+             * @param maxN Maximum number of elements /   
+             * @return Number of elements popped /   
+             */
+            size_t popBatch(T* out, size_t maxN) override
+            {
+                size_t count;
+                size_t pos = this->dequeuePos.load(std::memory_order_relaxed);
+
+                while (true) {
+                    count = 0;
+                    while (count < maxN) {
+                        size_t seq = this->buffer[(pos + count) & this->mask].sequence.load(std::memory_order_acquire);
+                        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + count + 1) != 0)
+                            break;
+                        ++count;
+                    }
+
+                    if (count == 0) {
+                        // The first cell is empty or already taken by another consumer
+                        //        
+                        size_t seq = this->buffer[pos & this->mask].sequence.load(std::memory_order_acquire);
+                        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0)
+                            return 0; // Ring is empty /  
+                        pos = this->dequeuePos.load(std::memory_order_relaxed);
+                        continue;
+                    }
+
+                    // Only a consumer that moves dequeuePos past a cell may empty it
+                    //     ,  dequeuePos  
+                    if (this->dequeuePos.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+                        break;
+                }
+
+                for (size_t i = 0; i < count; ++i) {
+                    Cell& cell = this->buffer[(pos + i) & this->mask];
+                    out[i] = std::move(cell.data);
+                    cell.sequence.store(pos + i + this->mask + 1, std::memory_order_release);
+                }
+                return count;
+            }
+
+            /**
+             * @brief Check if the ring is empty
+             * @brief ,    
+             *
+             * @return true if ring is empty (snapshot, may change immediately) / true    ( )
+             */
+            bool empty() override
+            {
+                size_t pos = this->dequeuePos.load(std::memory_order_relaxed);
+                size_t seq = this->buffer[pos & this->mask].sequence.load(std::memory_order_acquire);
+                return static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0;
+            }
+
+        private:
+            /**
+             * @brief Ring slot with its sequence counter
+             * @brief     
+             */
+            struct Cell
+            {
+                std::atomic<size_t> sequence; // Lap marker of the slot /   
+                T data;                       // Stored element /  
+            };
+
+            alignas(64) std::atomic<size_t> enqueuePos; // Producers position /  
+            alignas(64) std::atomic<size_t> dequeuePos; // Consumers position /  
+            alignas(64) std::unique_ptr<Cell[]> buffer; // Slots storage /  
+            size_t mask;                                // Index mask /  
+        };
+
+        /**
+         * @brief Priority queue made of a fixed set of lock-free FIFO bands
+         * @brief        FIFO-
+         *
+         * A task with priority p goes to band clamp(p, 0, numBands - 1), every
+         * band is a RingQueue and pop() scans from the highest band down.
+         * Ordering guarantees:
+         * - tasks of one band are popped in FIFO order;
+         * - a pop never takes a lower band while it observes a task in a higher
+         *   one, but a task pushed concurrently with the scan may be missed
+         *   until the next pop;
+         * - priorities that map to the same band are not ordered between
+         *   each other.
+         * PriorityQueue instead gives an exact order by priority with FIFO
+         * ties, at the cost of one mutex shared by all producers and consumers.
+         *
+         *    p    clamp(p, 0, numBands - 1),
+         *   -  RingQueue,  pop()    .
+         *  :
+         * -       FIFO;
+         * - pop     ,     ,
+         *    ,    ,  
+         *      pop;
+         * - ,    ,    .
+         * PriorityQueue, ,       FIFO 
+         *         .
+         *
+         * @tparam T Type of elements stored in the queue
+         * @tparam T  ,   
+         */
+        template <typename T>
+        class BandedPriorityQueue final : public QueueMutex<T>
+        {
+        public:
+            static constexpr int defaultBands = 8; // Default number of bands /    
+
+            /**
+             * @brief Constructor
+             * @brief 
+             *
+             * @param capacity Capacity of every band /   
+             * @param numBands Number of bands, at least 1 /  ,   1
+             */
+            explicit BandedPriorityQueue(size_t capacity = 65536, int numBands = defaultBands)
+            {
+                for (int i = 0; i < std::max(1, numBands); ++i)
+                    this->bands.push_back(std::make_unique<RingQueue<T>>(capacity));
+            }
+
+            /**
+             * @brief Push an element to band 0
+             * @brief     0
+             */
+            bool push(T&& value) override
+            {
+                return this->bands[0]->push(std::move(value));
+            }
+
+            /**
+             * @brief Push an element to the band of its priority
+             * @brief      
+             *
+             * @param value Element to push /   
+             * @param priority Task priority (higher = more important) /   ( = )
+             * @return true if successful, false if the band is full / true   , false   
+             */
+            bool push(T&& value, int priority) override
+            {
+                return this->band(priority).push(std::move(value));
+            }
+
+            /**
+             * @brief Push several elements to band 0
+             * @brief      0
+             */
+            size_t pushBulk(T* values, size_t count) override
+            {
+                return this->bands[0]->pushBulk(values, count);
+            }
+
+            /**
+             * @brief Push several elements with one priority
+             * @brief      
+             */
+            size_t pushBulk(T* values, size_t count, int priority)
+            {
+                return this->band(priority).pushBulk(values, count);
+            }
+
+            /**
+             * @brief Pop an element from the highest non-empty band
+             * @brief       
+             *
+             * @param value Reference to store popped element /     
+             * @return true if element was popped, false if all bands are empty / true   , false    
+             */
+            bool pop(T& value) override
+            {
+                for (size_t i = this->bands.size(); i-- > 0;) {
+                    if (this->bands[i]->pop(value))
+                        return true;
+                }
+                return false;
+            }
+
+            bool hasPriorities() const override { return true; }
+
+            /**
+             * @brief Remove the oldest element of the lowest non-empty band
+             * @brief        
+             */
+            bool evict(T& value) override
+            {
+                for (auto& band : this->bands) {
+                    if (band->pop(value))
+                        return true;
+                }
+                return false;
+            }
+
+            /**
+             * @brief Check if all bands are empty
+             * @brief ,    
+             */
+            bool empty() override
+            {
+                for (auto& band : this->bands) {
+                    if (!band->empty())
+                        return false;
+                }
+                return true;
+            }
+
+        private:
+            RingQueue<T>& band(int priority)
+            {
+                int last = static_cast<int>(this->bands.size()) - 1;
+                return *this->bands[std::min(std::max(priority, 0), last)];
+            }
+
+            std::vector<std::unique_ptr<RingQueue<T>>> bands; // Bands from lowest to highest /     
         };
     }
 }
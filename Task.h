@@ -0,0 +1,262 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include "TaskAllocator.h"
+
+namespace tp
+{
+    namespace component
+    {
+        /**
+         * @brief Table of operations for the callable stored in a Task
+         * @brief     ,   Task
+         */
+        struct TaskVTable
+        {
+            void (*invoke)(void* storage, int id);     // Call the callable /  
+            void (*relocate)(void* dst, void* src);    // Move to new storage and destroy source /       
+            void (*destroy)(void* storage);            // Destroy the callable /  
+        };
+
+        /**
+         * @brief Operations for callables kept inside the Task buffer
+         * @brief   ,     Task
+         */
+        template <typename F>
+        struct InlineTaskOps
+        {
+            static void invoke(void* storage, int id) { (*static_cast<F*>(storage))(id); }
+
+            static void relocate(void* dst, void* src)
+            {
+                new (dst) F(std::move(*static_cast<F*>(src)));
+                static_cast<F*>(src)->~F();
+            }
+
+            static void destroy(void* storage) { static_cast<F*>(storage)->~F(); }
+
+            static constexpr TaskVTable table = { &invoke, &relocate, &destroy };
+        };
+
+        template <typename F>
+        constexpr TaskVTable InlineTaskOps<F>::table;
+
+        /**
+         * @brief Operations for callables too large for the Task buffer
+         * @brief   ,      Task
+         *
+         * The callable lives in the slab arena of the creating thread.
+         *    -  .
+         */
+        template <typename F>
+        struct HeapTaskOps
+        {
+            static F*& get(void* storage) { return *static_cast<F**>(storage); }
+
+            static void invoke(void* storage, int id) { (*get(storage))(id); }
+
+            static void relocate(void* dst, void* src)
+            {
+                new (dst) F*(get(src));
+                get(src) = nullptr;
+            }
+
+            static void destroy(void* storage) { arenaDelete(get(storage)); }
+
+            static constexpr TaskVTable table = { &invoke, &relocate, &destroy };
+        };
+
+        template <typename F>
+        constexpr TaskVTable HeapTaskOps<F>::table;
+
+        /**
+         * @brief Share of a task in the state that waits for it, settled exactly once
+         * @brief      ,    
+         *
+         * Moves with the task. The task calls release() when it runs; a task
+         * destroyed unrun (rejected, dropped by DropOldest or by stop()) calls
+         * Actions::drop() from the destructor instead, so whoever waits for the
+         * task never hangs. Actions defines the nullable Target type and the
+         * static release(Target) and drop(Target) actions.
+         *
+         *    .   release()  ;
+         * ,    (,  DropOldest 
+         * stop()),    Actions::drop()  , 
+         *     . Actions  
+         * nullptr  Target    release(Target)  drop(Target).
+         */
+        template <typename Actions>
+        class TaskTicket
+        {
+        public:
+            using Target = typename Actions::Target;
+
+            explicit TaskTicket(Target target) : target(std::move(target)) {}
+
+            TaskTicket(TaskTicket&& other) noexcept : target(std::exchange(other.target, nullptr)) {}
+            TaskTicket(const TaskTicket&) = delete;
+            TaskTicket& operator=(const TaskTicket&) = delete;
+            TaskTicket& operator=(TaskTicket&&) = delete;
+
+            ~TaskTicket()
+            {
+                if (this->target)
+                    Actions::drop(std::exchange(this->target, nullptr));
+            }
+
+            void release() { Actions::release(std::exchange(this->target, nullptr)); }
+
+            const Target& get() const { return this->target; }
+
+        private:
+            Target target; // nullptr once settled / nullptr  
+        };
+    }
+
+    /**
+     * @brief Move-only task with small-buffer storage
+     * @brief       
+     *
+     * Callables up to inlineSize bytes with a non-throwing move constructor
+     * are stored inside the object without heap allocation, larger ones are
+     * kept in the slab arena of the creating thread, see SlabArena. The call
+     * signature matches std::function<void(int id)>.
+     *
+     *     inlineSize   
+     *        
+     *  ,   -  -  , . SlabArena.
+     *     std::function<void(int id)>.
+     */
+    class Task
+    {
+    public:
+        static constexpr size_t inlineSize = 64; // Size of inline storage /   
+
+        /**
+         * @brief Check if a callable type is stored without allocation
+         * @brief ,        
+         */
+        template <typename F>
+        static constexpr bool isInline()
+        {
+            return sizeof(F) <= inlineSize
+                && alignof(F) <= alignof(std::max_align_t)
+                && std::is_nothrow_move_constructible<F>::value;
+        }
+
+        Task() noexcept : vtable(nullptr) {}
+
+        /**
+         * @brief Construct a task from any callable accepting the thread ID
+         * @brief      ,  ID 
+         *
+         * @param f Callable object /  
+         */
+        template <typename F, typename Fn = typename std::decay<F>::type,
+            typename = typename std::enable_if<!std::is_same<Fn, Task>::value>::type>
+        Task(F&& f)
+        {
+            this->emplace<Fn>(std::forward<F>(f), std::integral_constant<bool, isInline<Fn>()>());
+        }
+
+        Task(Task&& other) noexcept : vtable(other.vtable), label(other.label)
+        {
+#ifdef TP_ENABLE_METRICS
+            this->enqueueTime = other.enqueueTime;
+#endif
+            if (this->vtable) {
+                this->vtable->relocate(&this->storage, &other.storage);
+                other.vtable = nullptr;
+            }
+        }
+
+        Task& operator=(Task&& other) noexcept
+        {
+            if (this != &other) {
+                this->reset();
+                if (other.vtable) {
+                    other.vtable->relocate(&this->storage, &other.storage);
+                    this->vtable = other.vtable;
+                    other.vtable = nullptr;
+                }
+#ifdef TP_ENABLE_METRICS
+                this->enqueueTime = other.enqueueTime;
+#endif
+                this->label = other.label;
+            }
+            return *this;
+        }
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        ~Task() { this->reset(); }
+
+        /**
+         * @brief Execute the task
+         * @brief  
+         *
+         * @param id Thread ID passed to the callable / ID ,  
+         * @throw std::bad_function_call if the task is empty /   
+         */
+        void operator()(int id)
+        {
+            if (!this->vtable)
+                throw std::bad_function_call();
+            this->vtable->invoke(&this->storage, id);
+        }
+
+        /**
+         * @brief Check if the task holds a callable
+         * @brief ,     
+         */
+        explicit operator bool() const noexcept { return this->vtable != nullptr; }
+
+        /**
+         * @brief Destroy the stored callable
+         * @brief   
+         */
+        void reset() noexcept
+        {
+            if (this->vtable) {
+                this->vtable->destroy(&this->storage);
+                this->vtable = nullptr;
+            }
+        }
+
+#ifdef TP_ENABLE_METRICS
+        std::uint64_t enqueueTime = 0; // Time the task was scheduled, ns /   , 
+#endif
+
+    private:
+        template <typename Fn, typename F>
+        void emplace(F&& f, std::true_type)
+        {
+            new (&this->storage) Fn(std::forward<F>(f));
+            this->vtable = &component::InlineTaskOps<Fn>::table;
+        }
+
+        template <typename Fn, typename F>
+        void emplace(F&& f, std::false_type)
+        {
+            new (&this->storage) Fn*(component::arenaNew<Fn>(std::forward<F>(f)));
+            this->vtable = &component::HeapTaskOps<Fn>::table;
+        }
+
+        alignas(std::max_align_t) unsigned char storage[inlineSize]; // Inline storage /  
+        const component::TaskVTable* vtable;                         // Operations of the stored callable /   
+
+    public:
+        // Declared last, so it fills the padding behind vtable
+        //  ,     vtable
+        const char* label = nullptr; // Trace label taken from TraceLabel at push /  ,   TraceLabel  
+    };
+}
+
+#endif // TASK_H
@@ -0,0 +1,358 @@
+#ifndef TASK_ALLOCATOR_H
+#define TASK_ALLOCATOR_H
+
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace tp
+{
+    namespace component
+    {
+        /**
+         * @brief Base of heap types with cache-line aligned members
+         * @brief      ,   -
+         *
+         * Before C++17 new ignores alignment above that of std::max_align_t, so
+         * such a type derives from this. The block is allocated with room to
+         * spare and the pointer the heap returned is kept just before the object.
+         *
+         *  C++17 new   ,   std::max_align_t,
+         *      .    ,
+         *  ,  ,    .
+         */
+        struct CacheAligned
+        {
+            static constexpr size_t alignment = 64; // Cache line / -
+
+            static void* operator new(size_t size)
+            {
+                void* raw = ::operator new(size + sizeof(void*) + alignment - 1);
+                std::uintptr_t address = (reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*) + alignment - 1) & ~std::uintptr_t(alignment - 1);
+                reinterpret_cast<void**>(address)[-1] = raw;
+                return reinterpret_cast<void*>(address);
+            }
+
+            static void operator delete(void* pointer) noexcept
+            {
+                if (pointer)
+                    ::operator delete(static_cast<void**>(pointer)[-1]);
+            }
+        };
+
+        /**
+         * @brief Per-thread slab arena for small task allocations
+         * @brief -      
+         *
+         * Blocks of four size classes are cut from 64 KB chunks. Each block
+         * starts with a header naming the arena it came from. A block freed
+         * by the owning thread goes back to a plain free list; a block freed
+         * by another thread is pushed onto a lock-free list of its owner, which
+         * the owner takes whole with one exchange when its own list runs dry.
+         * So a task allocated by a producer and destroyed by a worker costs a
+         * CAS and no lock, and neither side touches the global heap.
+         *
+         * The arena of an exiting thread is kept for the next new thread, since
+         * blocks of it may still be alive. Chunks are never returned to the system.
+         *
+         *         64 . 
+         *    ,  ,    .
+         * ,  -,   
+         *  ; ,   ,  
+         *   ,    
+         *  ,     .  ,
+         *      , 
+         *  CAS  ,         .
+         *
+         *        ,
+         *        .     .
+         */
+        class SlabArena : public CacheAligned
+        {
+        public:
+            static constexpr size_t numClasses = 4;        // Blocks of 64, 128, 256 and 512 bytes /  64, 128, 256  512 
+            static constexpr size_t minBlock = 64;         // Smallest block with its header /    
+            static constexpr size_t chunkSize = 64 * 1024; // Memory taken from the heap at once / ,     
+
+            /**
+             * @brief Check if an allocation is served by the arenas
+             * @brief ,    
+             */
+            static constexpr bool fits(size_t size, size_t align)
+            {
+                return size <= (minBlock << (numClasses - 1)) - sizeof(Header) && align <= alignof(Header);
+            }
+
+            /**
+             * @brief Allocate a block from the arena of the calling thread
+             * @brief      
+             *
+             * @param size Payload size, must fit /  ,  
+             */
+            static void* allocate(size_t size)
+            {
+                size_t sizeClass = 0;
+                while ((minBlock << sizeClass) < size + sizeof(Header))
+                    ++sizeClass;
+
+                SlabArena* arena = current();
+                Header* header;
+                if (arena) {
+                    header = arena->take(sizeClass);
+                }
+                else {
+                    // A thread past its arena's release uses the heap
+                    //       
+                    header = static_cast<Header*>(::operator new(minBlock << sizeClass));
+                    header->owner = nullptr;
+                }
+                header->sizeClass = sizeClass;
+                return header + 1;
+            }
+
+            /**
+             * @brief Return a block to the arena it came from
+             * @brief    ,    
+             */
+            static void deallocate(void* pointer) noexcept
+            {
+                Header* header = static_cast<Header*>(pointer) - 1;
+                SlabArena* owner = header->owner;
+                if (!owner) {
+                    ::operator delete(header);
+                    return;
+                }
+
+                size_t sizeClass = header->sizeClass;
+                if (owner == threadArena()) {
+                    header->next = owner->local[sizeClass];
+                    owner->local[sizeClass] = header;
+                    return;
+                }
+
+                std::atomic<Header*>& remote = owner->remote[sizeClass].head;
+                header->next = remote.load(std::memory_order_relaxed);
+                while (!remote.compare_exchange_weak(header->next, header, std::memory_order_release, std::memory_order_relaxed)) {
+                }
+            }
+
+            SlabArena(const SlabArena&) = delete;
+            SlabArena& operator=(const SlabArena&) = delete;
+
+        private:
+            /**
+             * @brief Header in front of every block
+             * @brief    
+             */
+            struct alignas(std::max_align_t) Header
+            {
+                SlabArena* owner;    // Arena of the block, nullptr for the heap /  , nullptr  
+                union {
+                    size_t sizeClass; // While allocated /  
+                    Header* next;     // While free /  
+                };
+            };
+
+            /**
+             * @brief Blocks freed by other threads, on a line of their own
+             * @brief ,   ,   
+             */
+            struct alignas(64) RemoteList
+            {
+                std::atomic<Header*> head{ nullptr };
+            };
+
+            /**
+             * @brief Releases the arena when its thread exits
+             * @brief      
+             */
+            struct ThreadRelease
+            {
+                ~ThreadRelease()
+                {
+                    SlabArena*& arena = threadArena();
+                    {
+                        std::lock_guard<std::mutex> lock(registryMutex());
+                        idleArenas().push_back(arena);
+                    }
+                    arena = nullptr;
+                    isThreadExited() = true;
+                }
+            };
+
+            SlabArena() = default;
+
+            Header* take(size_t sizeClass)
+            {
+                Header*& head = this->local[sizeClass];
+                if (!head) {
+                    head = this->remote[sizeClass].head.exchange(nullptr, std::memory_order_acquire);
+                    if (!head)
+                        this->carve(sizeClass);
+                }
+                Header* header = head;
+                head = header->next;
+                return header;
+            }
+
+            void carve(size_t sizeClass)
+            {
+                size_t blockSize = minBlock << sizeClass;
+                unsigned char* chunk = static_cast<unsigned char*>(::operator new(chunkSize));
+                this->chunks.push_back(chunk);
+
+                // Linked from the end so blocks are handed out in address order
+                //   ,      
+                Header* head = nullptr;
+                for (size_t i = chunkSize / blockSize; i-- > 0;) {
+                    Header* header = reinterpret_cast<Header*>(chunk + i * blockSize);
+                    header->owner = this;
+                    header->next = head;
+                    head = header;
+                }
+                this->local[sizeClass] = head;
+            }
+
+            /**
+             * @brief Arena of the calling thread, taken on first use
+             * @brief   ,    
+             *
+             * @return nullptr once the thread has released its arena / nullptr    
+             */
+            static SlabArena* current()
+            {
+                SlabArena*& arena = threadArena();
+                if (!arena && !isThreadExited()) {
+                    static thread_local ThreadRelease release;
+                    (void)release;
+
+                    std::lock_guard<std::mutex> lock(registryMutex());
+                    std::vector<SlabArena*>& idle = idleArenas();
+                    if (idle.empty()) {
+                        arena = new SlabArena();
+                    }
+                    else {
+                        arena = idle.back();
+                        idle.pop_back();
+                    }
+                }
+                return arena;
+            }
+
+            // Plain thread_local values stay usable while other thread_local objects are destroyed
+            //  thread_local  ,    thread_local 
+            static SlabArena*& threadArena()
+            {
+                static thread_local SlabArena* arena = nullptr;
+                return arena;
+            }
+
+            static bool& isThreadExited()
+            {
+                static thread_local bool isExited = false;
+                return isExited;
+            }
+
+            // Never destroyed, blocks may be freed during static destruction
+            //   ,       
+            static std::mutex& registryMutex()
+            {
+                static std::mutex* mutex = new std::mutex();
+                return *mutex;
+            }
+
+            static std::vector<SlabArena*>& idleArenas()
+            {
+                static std::vector<SlabArena*>* idle = new std::vector<SlabArena*>();
+                return *idle;
+            }
+
+            Header* local[numClasses] = {};          // Free blocks, owner only /  ,  
+            std::vector<unsigned char*> chunks;     // Memory of the arena /  
+            RemoteList remote[numClasses];          // Blocks freed by other threads / ,   
+        };
+
+        /**
+         * @brief Standard allocator backed by the slab arenas
+         * @brief     -
+         *
+         * Requests too large for the arenas go to the global heap. Usable with
+         * std::allocate_shared and with the allocator constructor of std::promise.
+         *
+         * ,    ,    .
+         *   std::allocate_shared   std::promise  .
+         */
+        template <typename T>
+        class ArenaAllocator
+        {
+        public:
+            using value_type = T;
+
+            ArenaAllocator() noexcept = default;
+
+            template <typename U>
+            ArenaAllocator(const ArenaAllocator<U>&) noexcept {}
+
+            T* allocate(size_t n)
+            {
+                if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+                    throw std::bad_alloc();
+                if (SlabArena::fits(n * sizeof(T), alignof(T)))
+                    return static_cast<T*>(SlabArena::allocate(n * sizeof(T)));
+                return static_cast<T*>(::operator new(n * sizeof(T)));
+            }
+
+            void deallocate(T* pointer, size_t n) noexcept
+            {
+                if (SlabArena::fits(n * sizeof(T), alignof(T)))
+                    SlabArena::deallocate(pointer);
+                else
+                    ::operator delete(pointer);
+            }
+
+            template <typename U>
+            bool operator==(const ArenaAllocator<U>&) const noexcept { return true; }
+
+            template <typename U>
+            bool operator!=(const ArenaAllocator<U>&) const noexcept { return false; }
+        };
+
+        /**
+         * @brief Create an object in the arena of the calling thread
+         * @brief      
+         */
+        template <typename T, typename... Args>
+        T* arenaNew(Args&&... args)
+        {
+            ArenaAllocator<T> allocator;
+            T* pointer = allocator.allocate(1);
+            try {
+                return new (pointer) T(std::forward<Args>(args)...);
+            }
+            catch (...) {
+                allocator.deallocate(pointer, 1);
+                throw;
+            }
+        }
+
+        /**
+         * @brief Destroy an object made by arenaNew() on any thread
+         * @brief  ,  arenaNew(),   
+         */
+        template <typename T>
+        void arenaDelete(T* pointer) noexcept
+        {
+            if (pointer) {
+                pointer->~T();
+                ArenaAllocator<T>().deallocate(pointer, 1);
+            }
+        }
+    }
+}
+
+#endif // TASK_ALLOCATOR_H
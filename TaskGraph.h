@@ -0,0 +1,773 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <new>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <exception>
+#include <future>
+#include <stdexcept>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+#include "ThreadPool.h"
+
+namespace tp
+{
+    template <typename T>
+    class TaskHandle;
+
+    namespace component
+    {
+        class TaskStateBase;
+
+        /**
+         * @brief Type-erased reference to the pool of a task
+         * @brief       
+         */
+        struct Spawner
+        {
+            void* pool = nullptr;                                    // Target pool, nullptr to run inline /  , nullptr    
+            void (*submit)(void* pool, Task&& task) = nullptr;       // Hands a task to the pool /   
+            void (*help)(void* pool, TaskStateBase& state) = nullptr; // Runs pool tasks until state is ready /      state
+
+            void operator()(Task&& task) const { this->submit(this->pool, std::move(task)); }
+
+            explicit operator bool() const { return this->pool != nullptr; }
+        };
+
+        /**
+         * @brief Completion state shared by the copies of a TaskHandle
+         * @brief  ,    TaskHandle
+         *
+         * Continuations are registered with onComplete() and run inline on the
+         * thread that completes the state, so they must be short: the public
+         * API only uses them to decrement counters or to hand a task to the pool.
+         *
+         *    onComplete()    ,
+         *  ,    :  API
+         *          .
+         */
+        class TaskStateBase
+        {
+        public:
+            explicit TaskStateBase(Spawner spawner) : spawner(std::move(spawner)) {}
+            virtual ~TaskStateBase() = default;
+
+            /**
+             * @brief Run callback once the state is complete, immediately if it already is
+             * @brief  callback   ,     
+             */
+            void onComplete(Task callback)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(this->mutex);
+                    if (!this->isReady) {
+                        this->continuations.push_back(std::move(callback));
+                        return;
+                    }
+                }
+                callback(-1);
+            }
+
+            /**
+             * @brief Complete with an exception, unless the state is already complete
+             * @brief   ,     
+             */
+            void fail(std::exception_ptr exception) { this->complete(exception); }
+
+            bool ready()
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                return this->isReady;
+            }
+
+            /**
+             * @brief Block until the state is complete
+             * @brief    
+             *
+             * On a worker of the pool, queued tasks are run meanwhile so that
+             * the worker is not lost to the pool while it waits.
+             *
+             *          ,
+             *        .
+             */
+            void wait()
+            {
+                if (this->spawner)
+                    this->spawner.help(this->spawner.pool, *this);
+
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->cv.wait(lock, [this]() { return this->isReady; });
+            }
+
+            /**
+             * @brief Block until the state is complete or timeout has passed
+             * @brief       timeout
+             */
+            void waitFor(std::chrono::microseconds timeout)
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->cv.wait_for(lock, timeout, [this]() { return this->isReady; });
+            }
+
+            /**
+             * @brief Hand a task to the pool, or run it here without a pool
+             * @brief         
+             */
+            void spawn(Task&& task)
+            {
+                if (this->spawner)
+                    this->spawner(std::move(task));
+                else
+                    task(-1);
+            }
+
+            const Spawner& getSpawner() const { return this->spawner; }
+            std::exception_ptr getError() const { return this->error; } // Valid once ready /   
+
+        protected:
+            /**
+             * @brief Publish the result and run continuations, only the first call counts
+             * @brief     ,    
+             */
+            void complete(std::exception_ptr exception = nullptr)
+            {
+                std::vector<Task> callbacks;
+                {
+                    std::lock_guard<std::mutex> lock(this->mutex);
+                    if (this->isReady)
+                        return;
+                    this->error = exception;
+                    this->isReady = true;
+                    callbacks.swap(this->continuations);
+                    this->cv.notify_all();
+                }
+                for (auto& callback : callbacks)
+                    callback(-1);
+            }
+
+        private:
+            Spawner spawner;                 // Pool for continuations /   
+            std::exception_ptr error;        // Exception of the task /  
+            std::mutex mutex;                // Protects isReady and continuations /  isReady  continuations
+            std::condition_variable cv;      // Signalled on completion /   
+            bool isReady = false;            // Result is published /  
+            std::vector<Task> continuations; // Callbacks waiting for completion /  ,  
+        };
+
+        /**
+         * @brief TaskTicket actions for a task that completes a state: an unrun task fails it with broken_promise
+         * @brief  TaskTicket  ,  :      broken_promise
+         */
+        struct TaskStateActions
+        {
+            using Target = std::shared_ptr<TaskStateBase>;
+
+            static void release(const Target&) {}
+            static void drop(const Target& state) { state->fail(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise))); }
+        };
+
+        using TaskStateTicket = TaskTicket<TaskStateActions>;
+
+        /**
+         * @brief Completion state holding a value of type T
+         * @brief      T
+         */
+        template <typename T>
+        class TaskState : public TaskStateBase
+        {
+        public:
+            using TaskStateBase::TaskStateBase;
+
+            ~TaskState() override
+            {
+                if (this->hasValue)
+                    reinterpret_cast<T*>(&this->storage)->~T();
+            }
+
+            template <typename U>
+            void setValue(U&& value)
+            {
+                new (&this->storage) T(std::forward<U>(value));
+                this->hasValue = true;
+                this->complete();
+            }
+
+            /**
+             * @brief Complete with the result of g(), or with its exception
+             * @brief   g()   
+             */
+            template <typename G>
+            void fulfill(G&& g)
+            {
+                try {
+                    new (&this->storage) T(g());
+                    this->hasValue = true;
+                }
+                catch (...) {
+                    this->fail(std::current_exception());
+                    return;
+                }
+                this->complete();
+            }
+
+            const T& value() const { return *reinterpret_cast<const T*>(&this->storage); }
+
+        private:
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage; // Result storage /  
+            bool hasValue = false;                                               // storage holds a T / storage  T
+        };
+
+        template <>
+        class TaskState<void> : public TaskStateBase
+        {
+        public:
+            using TaskStateBase::TaskStateBase;
+
+            void setValue() { this->complete(); }
+
+            template <typename G>
+            void fulfill(G&& g)
+            {
+                try {
+                    g();
+                }
+                catch (...) {
+                    this->fail(std::current_exception());
+                    return;
+                }
+                this->complete();
+            }
+        };
+
+        /**
+         * @brief Calls a continuation with the result of its antecedent
+         * @brief      
+         */
+        template <typename T>
+        struct ContinuationCall
+        {
+            template <typename F>
+            static auto call(F& f, int id, const TaskState<T>& state) -> decltype(f(id, state.value()))
+            {
+                return f(id, state.value());
+            }
+        };
+
+        template <>
+        struct ContinuationCall<void>
+        {
+            template <typename F>
+            static auto call(F& f, int id, const TaskState<void>&) -> decltype(f(id))
+            {
+                return f(id);
+            }
+        };
+
+        /**
+         * @brief Access to the state behind a TaskHandle
+         * @brief     TaskHandle
+         */
+        struct HandleAccess
+        {
+            template <typename T>
+            static const std::shared_ptr<TaskState<T>>& state(const TaskHandle<T>& handle) { return handle.state; }
+
+            template <typename T>
+            static TaskHandle<T> make(std::shared_ptr<TaskState<T>> state) { return TaskHandle<T>(std::move(state)); }
+        };
+
+        /**
+         * @brief Spawner that submits tasks to a pool
+         * @brief  ,    
+         */
+        template <typename QueuePolicy>
+        Spawner makeSpawner(BasicThreadPool<QueuePolicy>& pool)
+        {
+            Spawner spawner;
+            spawner.pool = &pool;
+            spawner.submit = [](void* target, Task&& task) {
+                static_cast<BasicThreadPool<QueuePolicy>*>(target)->submit(std::move(task));
+            };
+            spawner.help = [](void* target, TaskStateBase& state) {
+                static_cast<BasicThreadPool<QueuePolicy>*>(target)->helpUntil([&state]() { return state.ready(); },
+                    [&state]() { state.waitFor(std::chrono::microseconds(100)); });
+            };
+            return spawner;
+        }
+    }
+
+    /**
+     * @brief Handle to the result of a task that supports continuations
+     * @brief      
+     *
+     * Unlike std::future, a continuation attached with then() is pushed to
+     * the pool only when the result is ready, so no worker is blocked while
+     * waiting. Copies of a handle share one result. The pool must outlive
+     * every pending continuation.
+     *
+     *    std::future, ,   then(),
+     *      ,     
+     *   .     .
+     *       .
+     *
+     * @tparam T Result type, may be void /  ,   void
+     */
+    template <typename T>
+    class TaskHandle
+    {
+    public:
+        TaskHandle() = default;
+
+        /**
+         * @brief Check if the handle refers to a task
+         * @brief ,     
+         */
+        bool valid() const { return this->state != nullptr; }
+
+        /**
+         * @brief Check if the result is ready
+         * @brief ,   
+         */
+        bool isReady() const { return this->state->ready(); }
+
+        /**
+         * @brief Wait until the result is ready
+         * @brief   
+         *
+         * A worker of the pool runs other queued tasks while waiting, any
+         * other thread blocks.
+         *
+         *          
+         * ,    .
+         */
+        void wait() const { this->state->wait(); }
+
+        /**
+         * @brief Wait for the result and return it
+         * @brief     
+         *
+         * @return Result of the task (nothing for void) /   (  void)
+         * @throw The exception thrown by the task / ,  
+         * @throw std::future_error with broken_promise if the pool destroyed the task unrun /      
+         */
+        decltype(auto) get() const
+        {
+            this->state->wait();
+            if (this->state->getError())
+                std::rethrow_exception(this->state->getError());
+            return this->result();
+        }
+
+        /**
+         * @brief Attach a continuation that is pushed to the pool when this task finishes
+         * @brief  ,      
+         *
+         * f is called as f(id, value) or, for void, f(id). When this task throws,
+         * f is not called and the returned handle holds the same exception.
+         *
+         * f   f(id, value) ,  void, f(id).   
+         *  , f  ,   
+         *    .
+         *
+         * @param f Continuation / 
+         * @return Handle to the result of f /   f
+         */
+        template <typename F>
+        auto then(F f) const
+            -> TaskHandle<decltype(component::ContinuationCall<T>::call(std::declval<F&>(), 0, std::declval<const component::TaskState<T>&>()))>
+        {
+            using R = decltype(component::ContinuationCall<T>::call(std::declval<F&>(), 0, std::declval<const component::TaskState<T>&>()));
+
+            std::shared_ptr<component::TaskState<T>> antecedent = this->state;
+            auto result = std::allocate_shared<component::TaskState<R>>(component::ArenaAllocator<component::TaskState<R>>(), antecedent->getSpawner());
+
+            antecedent->onComplete([antecedent, result, f = std::move(f)](int) mutable {
+                if (antecedent->getError()) {
+                    result->fail(antecedent->getError());
+                    return;
+                }
+                result->spawn([ticket = component::TaskStateTicket(result), antecedent, result, f = std::move(f)](int id) mutable {
+                    ticket.release();
+                    result->fulfill([&]() -> R { return component::ContinuationCall<T>::call(f, id, *antecedent); });
+                });
+            });
+            return component::HandleAccess::make(result);
+        }
+
+    private:
+        friend struct component::HandleAccess;
+
+        explicit TaskHandle(std::shared_ptr<component::TaskState<T>> state) : state(std::move(state)) {}
+
+        template <typename U = T>
+        typename std::enable_if<!std::is_void<U>::value, const U&>::type result() const { return this->state->value(); }
+
+        template <typename U = T>
+        typename std::enable_if<std::is_void<U>::value>::type result() const {}
+
+        std::shared_ptr<component::TaskState<T>> state; // Shared result /  
+    };
+
+    /**
+     * @brief Push a task and get a handle that supports continuations
+     * @brief        
+     *
+     * @param pool Pool to run on /   
+     * @param f Function called as f(id, rest...) / ,   f(id, rest...)
+     * @param rest Arguments / 
+     * @return Handle to the result /  
+     *
+     * @example
+     * auto handle = tp::spawn(pool, [](int) { return 21; })
+     *     .then([](int, int x) { return x * 2; });
+     */
+    template <typename QueuePolicy, typename F, typename... Rest>
+    auto spawn(BasicThreadPool<QueuePolicy>& pool, F&& f, Rest&&... rest) -> TaskHandle<decltype(f(0, rest...))>
+    {
+        using R = decltype(f(0, rest...));
+
+        // Handles are made per task, so their states come from the slab arena
+        //     ,      -
+        auto state = std::allocate_shared<component::TaskState<R>>(component::ArenaAllocator<component::TaskState<R>>(), component::makeSpawner(pool));
+        auto call = std::bind(std::forward<F>(f), std::placeholders::_1, std::forward<Rest>(rest)...);
+
+        pool.submit([ticket = component::TaskStateTicket(state), state, call = std::move(call)](int id) mutable {
+            ticket.release();
+            state->fulfill([&]() -> R { return call(id); });
+        });
+        return component::HandleAccess::make(state);
+    }
+
+    namespace component
+    {
+        /**
+         * @brief Complete result when every state in states has completed
+         * @brief  result      states
+         */
+        inline void whenAll(const std::vector<std::shared_ptr<TaskStateBase>>& states, const std::shared_ptr<TaskState<void>>& result)
+        {
+            if (states.empty()) {
+                result->setValue();
+                return;
+            }
+
+            auto inputs = std::make_shared<std::vector<std::shared_ptr<TaskStateBase>>>(states);
+            auto remaining = std::make_shared<std::atomic<size_t>>(states.size());
+            for (auto& state : states) {
+                state->onComplete([inputs, result, remaining](int) {
+                    if (remaining->fetch_sub(1, std::memory_order_acq_rel) != 1)
+                        return;
+
+                    // Report the first failure in input order
+                    //        
+                    for (auto& input : *inputs) {
+                        if (input->getError()) {
+                            result->fail(input->getError());
+                            return;
+                        }
+                    }
+                    result->setValue();
+                    });
+            }
+        }
+
+        /**
+         * @brief Complete result with the index of the first completed state
+         * @brief  result    
+         */
+        inline void whenAny(const std::vector<std::shared_ptr<TaskStateBase>>& states, const std::shared_ptr<TaskState<size_t>>& result)
+        {
+            if (states.empty())
+                throw std::invalid_argument("when_any requires at least one handle");
+
+            auto isDone = std::make_shared<std::atomic<bool>>(false);
+            for (size_t i = 0; i < states.size(); ++i) {
+                states[i]->onComplete([result, isDone, i](int) {
+                    if (!isDone->exchange(true, std::memory_order_acq_rel))
+                        result->setValue(i);
+                    });
+            }
+        }
+    }
+
+    /**
+     * @brief Handle that becomes ready when every handle is ready
+     * @brief ,     
+     *
+     * Waiting on the result does not block a worker. The result holds the
+     * first exception in input order, if any.
+     *
+     *      .   
+     *     ,   .
+     *
+     * @param handles Handles to wait for /  
+     * @return Handle without value /   
+     */
+    template <typename T>
+    TaskHandle<void> when_all(const std::vector<TaskHandle<T>>& handles)
+    {
+        std::vector<std::shared_ptr<component::TaskStateBase>> states;
+        for (auto& handle : handles)
+            states.push_back(component::HandleAccess::state(handle));
+
+        auto result = std::make_shared<component::TaskState<void>>(states.empty() ? component::Spawner() : states.front()->getSpawner());
+        component::whenAll(states, result);
+        return component::HandleAccess::make(result);
+    }
+
+    template <typename T, typename... Ts>
+    TaskHandle<void> when_all(const TaskHandle<T>& first, const TaskHandle<Ts>&... rest)
+    {
+        std::vector<std::shared_ptr<component::TaskStateBase>> states = {
+            component::HandleAccess::state(first), component::HandleAccess::state(rest)...
+        };
+
+        auto result = std::make_shared<component::TaskState<void>>(states.front()->getSpawner());
+        component::whenAll(states, result);
+        return component::HandleAccess::make(result);
+    }
+
+    /**
+     * @brief Handle that becomes ready when any handle is ready
+     * @brief ,      
+     *
+     * @param handles Handles to wait for, at least one /  ,   
+     * @return Index of the first finished handle, failed or not /    ,    
+     * @throw std::invalid_argument if handles is empty /  handles 
+     */
+    template <typename T>
+    TaskHandle<size_t> when_any(const std::vector<TaskHandle<T>>& handles)
+    {
+        std::vector<std::shared_ptr<component::TaskStateBase>> states;
+        for (auto& handle : handles)
+            states.push_back(component::HandleAccess::state(handle));
+
+        auto result = std::make_shared<component::TaskState<size_t>>(states.empty() ? component::Spawner() : states.front()->getSpawner());
+        component::whenAny(states, result);
+        return component::HandleAccess::make(result);
+    }
+
+    template <typename T, typename... Ts>
+    TaskHandle<size_t> when_any(const TaskHandle<T>& first, const TaskHandle<Ts>&... rest)
+    {
+        std::vector<std::shared_ptr<component::TaskStateBase>> states = {
+            component::HandleAccess::state(first), component::HandleAccess::state(rest)...
+        };
+
+        auto result = std::make_shared<component::TaskState<size_t>>(states.front()->getSpawner());
+        component::whenAny(states, result);
+        return component::HandleAccess::make(result);
+    }
+
+    /**
+     * @brief Dependency graph of tasks
+     * @brief   
+     *
+     * A node is pushed to the pool only when all its predecessors have
+     * finished, so no worker ever waits for another node. After a node
+     * throws, the nodes that have not started yet are skipped and the
+     * handle returned by run() holds the first exception. The graph can be
+     * run several times; every run works on its own copy of the nodes.
+     *
+     *         ,
+     *        .     
+     *    ,  ,  run(),
+     *   .     , 
+     *      .
+     *
+     * @example
+     * tp::TaskGraph graph(pool);
+     * size_t loadNode = graph.add([](int) { load(); });
+     * size_t parseNode = graph.add([](int) { parse(); });
+     * graph.precede(loadNode, parseNode);
+     * graph.run().get();
+     */
+    class TaskGraph
+    {
+    public:
+        /**
+         * @brief Constructor
+         * @brief 
+         *
+         * @param pool Pool that runs the nodes / ,  
+         */
+        template <typename QueuePolicy>
+        explicit TaskGraph(BasicThreadPool<QueuePolicy>& pool) : spawner(component::makeSpawner(pool)) {}
+
+        /**
+         * @brief Add a node
+         * @brief  
+         *
+         * @param f Copyable function called as f(id) /  ,   f(id)
+         * @return Index of the node /  
+         */
+        template <typename F>
+        size_t add(F&& f)
+        {
+            Node node;
+            node.body = std::forward<F>(f);
+            this->nodes.push_back(std::move(node));
+            return this->nodes.size() - 1;
+        }
+
+        /**
+         * @brief Make second start only after first has finished
+         * @brief  second    first
+         *
+         * @throw std::out_of_range for an unknown node /   
+         */
+        void precede(size_t first, size_t second)
+        {
+            if (first >= this->nodes.size() || second >= this->nodes.size())
+                throw std::out_of_range("TaskGraph node index out of range");
+
+            this->nodes[first].successors.push_back(second);
+            ++this->nodes[second].numPredecessors;
+        }
+
+        /**
+         * @brief Number of nodes
+         * @brief  
+         */
+        size_t size() const { return this->nodes.size(); }
+
+        /**
+         * @brief Start the graph
+         * @brief  
+         *
+         * @return Handle that is ready when every node has finished / ,     
+         * @throw std::invalid_argument if the graph has a cycle /     
+         */
+        TaskHandle<void> run() const
+        {
+            this->checkAcyclic();
+
+            auto result = std::make_shared<component::TaskState<void>>(this->spawner);
+            if (this->nodes.empty()) {
+                result->setValue();
+                return component::HandleAccess::make(result);
+            }
+
+            auto state = std::make_shared<Run>(this->nodes, this->spawner, result);
+            for (size_t i = 0; i < this->nodes.size(); ++i) {
+                if (this->nodes[i].numPredecessors == 0)
+                    Run::spawn(state, i);
+            }
+            return component::HandleAccess::make(result);
+        }
+
+    private:
+        /**
+         * @brief Node of the graph
+         * @brief  
+         */
+        struct Node
+        {
+            std::function<void(int)> body;  // Work of the node /  
+            std::vector<size_t> successors; // Nodes waiting for this one / ,  
+            size_t numPredecessors = 0;     // Number of incoming edges /   
+        };
+
+        /**
+         * @brief State of one run of the graph
+         * @brief    
+         */
+        struct Run
+        {
+            Run(const std::vector<Node>& nodes, const component::Spawner& spawner, std::shared_ptr<component::TaskState<void>> result)
+                : nodes(nodes), spawner(spawner), pending(new std::atomic<size_t>[nodes.size()]),
+                remaining(nodes.size()), result(std::move(result))
+            {
+                for (size_t i = 0; i < nodes.size(); ++i)
+                    this->pending[i].store(nodes[i].numPredecessors, std::memory_order_relaxed);
+            }
+
+            static void spawn(const std::shared_ptr<Run>& self, size_t index)
+            {
+                self->spawner([ticket = component::TaskStateTicket(self->result), self, index](int id) mutable {
+                    ticket.release();
+                    self->execute(self, index, id);
+                });
+            }
+
+            void execute(const std::shared_ptr<Run>& self, size_t index, int id)
+            {
+                if (!this->isFailed.load(std::memory_order_acquire)) {
+                    try {
+                        this->nodes[index].body(id);
+                    }
+                    catch (...) {
+                        std::lock_guard<std::mutex> lock(this->mutex);
+                        if (!this->error)
+                            this->error = std::current_exception();
+                        this->isFailed.store(true, std::memory_order_release);
+                    }
+                }
+
+                // Release successors whose last predecessor was this node
+                //  ,       
+                for (size_t next : this->nodes[index].successors) {
+                    if (this->pending[next].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                        spawn(self, next);
+                }
+
+                if (this->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    std::lock_guard<std::mutex> lock(this->mutex);
+                    if (this->error)
+                        this->result->fail(this->error);
+                    else
+                        this->result->setValue();
+                }
+            }
+
+            std::vector<Node> nodes;                          // Copy of the graph /  
+            component::Spawner spawner;                       // Pool of the graph /  
+            std::unique_ptr<std::atomic<size_t>[]> pending;   // Unfinished predecessors per node /   
+            std::atomic<size_t> remaining;                    // Unfinished nodes /  
+            std::atomic<bool> isFailed{ false };              // A node has thrown /   
+            std::exception_ptr error;                         // First exception /  
+            std::mutex mutex;                                 // Protects error /  error
+            std::shared_ptr<component::TaskState<void>> result; // Handle of the run /  
+        };
+
+        /**
+         * @brief Kahn's algorithm: every node must be reachable from a root
+         * @brief  :       
+         */
+        void checkAcyclic() const
+        {
+            std::vector<size_t> degree(this->nodes.size());
+            std::vector<size_t> ready;
+            for (size_t i = 0; i < this->nodes.size(); ++i) {
+                degree[i] = this->nodes[i].numPredecessors;
+                if (degree[i] == 0)
+                    ready.push_back(i);
+            }
+
+            size_t visited = 0;
+            while (!ready.empty()) {
+                size_t index = ready.back();
+                ready.pop_back();
+                ++visited;
+                for (size_t next : this->nodes[index].successors) {
+                    if (--degree[next] == 0)
+                        ready.push_back(next);
+                }
+            }
+
+            if (visited != this->nodes.size())
+                throw std::invalid_argument("TaskGraph contains a cycle");
+        }
+
+        std::vector<Node> nodes;    // Nodes in insertion order /    
+        component::Spawner spawner; // Submits to the pool /    
+    };
+}
+
+#endif // TASK_GRAPH_H
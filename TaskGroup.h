@@ -0,0 +1,239 @@
+#ifndef TASK_GROUP_H
+#define TASK_GROUP_H
+
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <utility>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+#include "ThreadPool.h"
+
+namespace tp
+{
+    namespace component
+    {
+        /**
+         * @brief Shared state of a task group
+         * @brief    
+         */
+        class TaskGroupState
+        {
+        public:
+            /**
+             * @brief Count a task handed to the pool
+             * @brief  ,  
+             */
+            void add() { this->pending.fetch_add(1, std::memory_order_relaxed); }
+
+            /**
+             * @brief Count a finished task, wake waiters after the last one
+             * @brief   ,    
+             *
+             * Only the last task takes the mutex.
+             *     .
+             */
+            void done()
+            {
+                if (this->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    std::lock_guard<std::mutex> lock(this->mutex);
+                    this->cv.notify_all();
+                }
+            }
+
+            /**
+             * @brief Keep the exception if it is the first one
+             * @brief  ,   
+             */
+            void fail(std::exception_ptr exception)
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                if (!this->error)
+                    this->error = exception;
+            }
+
+            bool ready() const { return this->pending.load(std::memory_order_acquire) == 0; }
+
+            /**
+             * @brief Block until every task has finished or timeout has passed
+             * @brief        timeout
+             */
+            void waitFor(std::chrono::microseconds timeout)
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->cv.wait_for(lock, timeout, [this]() { return this->ready(); });
+            }
+
+            /**
+             * @brief Block until every task has finished
+             * @brief     
+             */
+            void wait()
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->cv.wait(lock, [this]() { return this->ready(); });
+            }
+
+            /**
+             * @brief Take the first exception and reset it
+             * @brief     
+             */
+            std::exception_ptr takeError()
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                return std::exchange(this->error, nullptr);
+            }
+
+        private:
+            std::atomic<size_t> pending{ 0 }; // Tasks not finished yet /    
+            std::exception_ptr error;         // First exception of a task /   
+            std::mutex mutex;                 // Protects error, pairs with cv /  error,   cv
+            std::condition_variable cv;       // Signalled by the last task /   
+        };
+
+        /**
+         * @brief TaskTicket actions for a task of a group: counted as finished either way
+         * @brief  TaskTicket   :      
+         */
+        struct TaskGroupActions
+        {
+            using Target = std::shared_ptr<TaskGroupState>;
+
+            static void release(const Target& state) { state->done(); }
+            static void drop(const Target& state) { state->done(); }
+        };
+
+        using TaskGroupTicket = TaskTicket<TaskGroupActions>;
+    }
+
+    /**
+     * @brief Group of fire-and-forget tasks waited for as a whole
+     * @brief    ,  
+     *
+     * The whole group shares one atomic counter and one condition variable,
+     * so waiting for thousands of tasks costs no future per task. wait()
+     * rethrows the first exception thrown by a task; the other tasks still
+     * run. The group can be reused after wait(). The destructor waits too.
+     *
+     * On a worker of the pool wait() always runs queued tasks meanwhile, so a
+     * task that waits for its children cannot starve the pool. On another
+     * thread it does so only when isHelping is set; such tasks get the ID -1.
+     *
+     *          ,
+     *       future   . wait()
+     *     ;    
+     * .  wait()    . 
+     *  .
+     *
+     *     wait()     , 
+     * ,   ,    .   
+     *      isHelping;    ID -1.
+     *
+     * @example
+     * tp::TaskGroup group(pool);
+     * for (auto& item : items)
+     *     group.run([&item](int id) { process(item); });
+     * group.wait(); // Throws the first exception /   
+     */
+    class TaskGroup
+    {
+    public:
+        /**
+         * @brief Constructor
+         * @brief 
+         *
+         * @param pool Pool that runs the tasks / ,  
+         * @param isHelping Run queued tasks in wait() outside the pool too /    wait()   
+         */
+        template <typename QueuePolicy>
+        explicit TaskGroup(BasicThreadPool<QueuePolicy>& pool, bool isHelping = false)
+            : pool(&pool), isHelping(isHelping), state(std::make_shared<component::TaskGroupState>())
+        {
+            this->submitTask = [](void* target, Task&& task) {
+                static_cast<BasicThreadPool<QueuePolicy>*>(target)->submit(std::move(task));
+            };
+            this->runPendingTask = [](void* target) {
+                return static_cast<BasicThreadPool<QueuePolicy>*>(target)->runPendingTask();
+            };
+            this->isWorkerThread = [](void* target) {
+                return static_cast<BasicThreadPool<QueuePolicy>*>(target)->isWorkerThread();
+            };
+        }
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        ~TaskGroup()
+        {
+            try {
+                this->wait();
+            }
+            catch (...) {
+            }
+        }
+
+        /**
+         * @brief Submit a task with arguments to the group
+         * @brief      
+         *
+         * @tparam F Function type /  
+         * @tparam Rest Argument types /  
+         * @throw QueueFullError if a bounded pool rejects the task /     
+         */
+        template <typename F, typename... Rest>
+        auto run(F&& f, Rest&&... rest) -> decltype(void(f(0, rest...)))
+        {
+            auto body = std::bind(std::forward<F>(f), std::placeholders::_1, std::forward<Rest>(rest)...);
+            this->state->add();
+            this->submitTask(this->pool, Task([ticket = component::TaskGroupTicket(this->state), body = std::move(body)](int id) mutable {
+                try {
+                    body(id);
+                }
+                catch (...) {
+                    ticket.get()->fail(std::current_exception());
+                }
+                ticket.release();
+            }));
+        }
+
+        /**
+         * @brief Block until every task of the group has finished
+         * @brief      
+         *
+         * @throw The first exception thrown by a task since the last wait() /      wait()
+         */
+        void wait()
+        {
+            if (this->isHelping || this->isWorkerThread(this->pool)) {
+                while (!this->state->ready()) {
+                    if (!this->runPendingTask(this->pool))
+                        this->state->waitFor(std::chrono::microseconds(100));
+                }
+            }
+            else {
+                this->state->wait();
+            }
+
+            if (std::exception_ptr error = this->state->takeError())
+                std::rethrow_exception(error);
+        }
+
+        /**
+         * @brief Check if every task of the group has finished
+         * @brief ,     
+         */
+        bool ready() const { return this->state->ready(); }
+
+    private:
+        void* pool;                                  // Pool with erased type /    
+        void (*submitTask)(void*, Task&&) = nullptr; // Submits a task to the pool /    
+        bool (*runPendingTask)(void*) = nullptr;     // Runs one queued task /     
+        bool (*isWorkerThread)(void*) = nullptr;     // Is the caller a worker of the pool /      
+        bool isHelping;                              // Help outside the pool too /    
+        std::shared_ptr<component::TaskGroupState> state; // Shared with the tasks /   
+    };
+}
+
+#endif // TASK_GROUP_H
@@ -1,48 +1,73 @@
 #include "ThreadPool.h"
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#endif
+
+template <typename QueuePolicy>
+constexpr size_t tp::BasicThreadPool<QueuePolicy>::defaultQueueCapacity;
+
+template <typename QueuePolicy>
+thread_local tp::component::WorkerContext tp::BasicThreadPool<QueuePolicy>::currentWorker;
 
 // CONSTRUCTORS & DESTRUCTOR
 //   
 
-tp::ThreadPool::ThreadPool(TypePool typePool)
+template <typename QueuePolicy>
+tp::BasicThreadPool<QueuePolicy>::BasicThreadPool(TypePool typePool)
 {
-    init(typePool);
-
     // Use hardware concurrency as default thread count
     //        
-    int numThreads = std::thread::hardware_concurrency();
-    if (numThreads == 0) {
-        numThreads = 1; // Fallback if hardware_concurrency returns 0 /    hardware_concurrency  0
-    }
+    PoolConfig config;
+    config.typePool = typePool;
 
-    threads.resize(numThreads);
-
-    // Create and configure worker threads
-    //     
-    for (int i = 0; i < numThreads; ++i)
-    {
-        threads[i].isNotWorking = std::make_shared<std::atomic<bool>>(false);
-        setThread(i);
-    }
+    init(config);
+    addThreads(config.countThreads);
 }
 
-tp::ThreadPool::ThreadPool(unsigned int numThreads, TypePool typePool)
+template <typename QueuePolicy>
+tp::BasicThreadPool<QueuePolicy>::BasicThreadPool(unsigned int numThreads, TypePool typePool, size_t queueCapacity)
 {
+    PoolConfig config;
+    config.countThreads = numThreads;
+    config.typePool = typePool;
+    config.queueCapacity = queueCapacity;
+
     // Initialize pool state
     //   
-    init(typePool);
-    threads.resize(numThreads);
+    init(config);
+    addThreads(config.countThreads);
+}
 
-    // Create and configure worker threads
-    //     
-    for (int i = 0; i < numThreads; ++i)
-    {
-        threads[i].isNotWorking = std::make_shared<std::atomic<bool>>(false);
-        setThread(i);
-    }
+template <typename QueuePolicy>
+tp::BasicThreadPool<QueuePolicy>::BasicThreadPool(const PoolConfig& config)
+{
+    init(config);
+
+    // The elastic mode starts within its bounds
+    //      
+    unsigned int numThreads = config.countThreads;
+    if (isElastic())
+        numThreads = std::min(std::max(numThreads, this->config.minThreads), this->config.maxThreads);
+    addThreads(numThreads);
 }
 
-tp::ThreadPool::~ThreadPool()
+template <typename QueuePolicy>
+tp::BasicThreadPool<QueuePolicy>::~BasicThreadPool()
 {
     // Graceful shutdown - wait for tasks to complete
     //   -   
@@ -52,7 +77,8 @@ tp::ThreadPool::~ThreadPool()
 // POOL MANAGEMENT METHODS
 //   
 
-void tp::ThreadPool::stop(bool isWait)
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::stop(bool isWait)
 {
     if (!isWait) {
         // Immediate stop - clear queue and force threads to stop
@@ -61,10 +87,6 @@ void tp::ThreadPool::stop(bool isWait)
             return;
 
         isStop = true;
-        for (int i = 0, n = size(); i < n; ++i) {
-            *threads[i].isNotWorking = true;
-        }
-        this->clearQueue();
     }
     else {
         // Graceful stop - allow tasks to complete naturally
@@ -74,109 +96,550 @@ void tp::ThreadPool::stop(bool isWait)
         isDone = true;
     }
 
+    // Timers that have not fired are dropped, the flags above stop new ones
+    //   ,    
+    clearTimers();
+
+    // Release a resize() waiting for parked workers. Any later resize() sees
+    // the flags, so the worker list no longer changes
+    //  resize(),   .  
+    // resize()  ,      
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        parkCv.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> guard(this->resizeMutex);
+        if (isStop) {
+            for (auto& thread : threads)
+                thread.block->isNotWorking = true;
+            this->clearQueue();
+        }
+
+        // Workers parked by resize() are woken one by one on their own
+        // condition, they never line up on the pool mutex
+        // ,  resize(),     
+        //          
+        for (auto& thread : threads) {
+            std::lock_guard<std::mutex> lock(thread.block->parkMutex);
+            thread.block->parkCv.notify_one();
+        }
+    }
+
     {
         // Notify all waiting threads to wake up and check conditions
         //       
         std::unique_lock<std::mutex> lock(this->mutex);
         cv.notify_all();
     }
-
-    // Wait for all threads to finish execution
-    //     
-    for (int i = 0, n = size(); i < n; ++i) {
-        if (threads[i].thread && threads[i].thread->joinable())
-            threads[i].thread->join();
+    {
+        std::unique_lock<std::mutex> lock(this->spaceMutex);
+        spaceCv.notify_all();
+    }
+    {
+        std::unique_lock<std::mutex> lock(this->idleMutex);
+        idleCv.notify_all();
     }
 
+    // Wait for all threads to finish execution. Every worker joins two others
+    // on exit, so joining the first one waits for all of them. resizeMutex is
+    // not held here, a task calling resize() must be able to return
+    //     .    
+    //   ,      .
+    // resizeMutex   , ,  resize(), 
+    //   
+    if (!threads.empty() && threads.front().thread && threads.front().thread->joinable())
+        threads.front().thread->join();
+
     // Cleanup resources
     //  
+    std::lock_guard<std::mutex> guard(this->resizeMutex);
     clearQueue();
     threads.clear();
+    numActive = 0;
 }
 
-void tp::ThreadPool::resize(unsigned int numThreads)
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::waitIdle(std::chrono::milliseconds timeout)
 {
-    if (!isStop && !isDone) {
-        int oldNumThread = threads.size();
+    if (isWorkerThread())
+        return false;
 
-        if (oldNumThread <= numThreads) {
-            // Increase thread count - add new worker threads
-            //    -    
-            threads.resize(numThreads);
-            for (int i = oldNumThread; i < numThreads; ++i)
-            {
-                threads[i].isNotWorking = std::make_shared<std::atomic<bool>>(false);
-                setThread(i);
-            }
+    auto isIdle = [this]() { return numInFlight.load(std::memory_order_acquire) == 0 || isDone || isStop; };
+    ++numIdleWaiters;
+
+    // Pairs with the fence in finishTasks()
+    //    finishTasks()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    {
+        std::unique_lock<std::mutex> lock(this->idleMutex);
+        if (timeout.count() > 0)
+            idleCv.wait_for(lock, timeout, isIdle);
+        else
+            idleCv.wait(lock, isIdle);
+    }
+    --numIdleWaiters;
+
+    return numInFlight.load(std::memory_order_acquire) == 0;
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::resize(unsigned int numThreads)
+{
+    std::lock_guard<std::mutex> guard(this->resizeMutex);
+    if (isStop || isDone)
+        return;
+
+    resizeLocked(numThreads);
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::resizeLocked(unsigned int numThreads)
+{
+    unsigned int oldNumThread = numActive;
+    if (oldNumThread < numThreads) {
+        // Increase thread count - wake parked workers, then add new ones
+        //    -  ,   
+        unsigned int numResumed = std::min<unsigned int>(numThreads, static_cast<unsigned int>(threads.size()));
+        for (unsigned int i = oldNumThread; i < numResumed; ++i) {
+            // Only the resumed workers are woken, each on its own condition
+            //    ,    
+            component::WorkerBlock& block = *threads[i].block;
+            std::lock_guard<std::mutex> lock(block.parkMutex);
+            block.isParked = false;
+            block.parkCv.notify_one();
         }
-        else {
-            // Decrease thread count - stop excess threads
-            //    -   
-            for (int i = oldNumThread - 1; i >= numThreads; --i)
-            {
-                *threads[i].isNotWorking = true;
-                threads[i].thread->detach();
-            }
+        numActive = numResumed;
 
-            // Notify detached threads to stop
-            //     
-            std::unique_lock<std::mutex> lock(mutex);
-            cv.notify_all();
-            lock.unlock();
+        if (numResumed < numThreads)
+            addThreads(numThreads);
+        else
+            updateWorkers();
+    }
+    else if (oldNumThread > numThreads) {
+        // Decrease thread count - park excess workers after their current task
+        //    -      
+        std::unique_lock<std::mutex> lock(this->mutex);
+        for (unsigned int i = numThreads; i < oldNumThread; ++i) {
+            std::lock_guard<std::mutex> parkLock(threads[i].block->parkMutex);
+            threads[i].block->isParked = true;
+        }
+        numActive = numThreads;
+        cv.notify_all();
+        lock.unlock();
 
-            threads.resize(numThreads);
+        updateWorkers();
+
+        // A worker cannot wait here: the workers it waits for may be waiting for its task
+        //      :       
+        if (!isWorkerThread()) {
+            size_t numExcess = threads.size() - numThreads;
+            lock.lock();
+            parkCv.wait(lock, [this, numExcess]() { return numParked == numExcess || isStop || isDone; });
         }
     }
 }
 
-void tp::ThreadPool::clearQueue()
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::clearQueue()
 {
-    std::function<void(int id)>* fun;
+    Task task;
+    Task* box;
+    std::int64_t numDropped = 0;
 
     // Delete all pending tasks to prevent memory leaks
     //        
-    while (queue->pop(fun))
-        delete fun;
+    for (auto& queue : queues) {
+        while (queue->pop(task)) {
+            task.reset();
+            countQueued(-1);
+            ++numDropped;
+        }
+    }
+    notifySpace(queues.size() + 1);
+
+    for (auto& batch : batches) {
+        while (batch->tasks.pop(task)) {
+            task.reset();
+            countQueued(-1);
+            ++numDropped;
+        }
+    }
+
+    std::shared_ptr<component::SlotList> slotList = std::atomic_load(&slots);
+    if (slotList) {
+        for (auto& slot : *slotList) {
+            if ((box = slot->take()) != nullptr) {
+                component::arenaDelete(box);
+                countQueued(-1);
+                ++numDropped;
+            }
+        }
+    }
+
+    // Local deques are drained from the steal end
+    //      
+    std::shared_ptr<component::DequeList> list = std::atomic_load(&deques);
+    if (list) {
+        for (auto& node : *list) {
+            for (auto& deque : node) {
+                while (deque->steal(box)) {
+                    component::arenaDelete(box);
+                    countQueued(-1);
+                    ++numDropped;
+                }
+            }
+        }
+    }
+
+    if (numDropped > 0)
+        finishTasks(numDropped);
 }
 
 // INTERNAL METHODS
 //  
 
-std::thread& tp::ThreadPool::getThread(int i)
+template <typename QueuePolicy>
+std::thread& tp::BasicThreadPool<QueuePolicy>::getThread(int i)
 {
-    if (i < 0 || i >= threads.size()) {
+    if (i < 0 || i >= size()) {
         throw std::out_of_range("Thread index out of range");
     }
     return *this->threads[i].thread;
 }
 
-void tp::ThreadPool::init(TypePool typePool)
+unsigned int tp::component::defaultThreadCount()
 {
-    this->typePool = typePool;
+    unsigned int numThreads = std::thread::hardware_concurrency();
+    if (numThreads == 0) {
+        numThreads = 1; // Fallback if hardware_concurrency returns 0 /    hardware_concurrency  0
+    }
+    return numThreads;
+}
 
-    if (typePool == TypePool::Normal)
-    {
-        queue = std::make_unique <tp::component::NormalQueue<std::function<void(int id)>*>>();
+/**
+ * @brief Parse a Linux CPU list such as "0-3,8-11"
+ * @brief    Linux  "0-3,8-11"
+ */
+static std::vector<int> parseCpuList(const std::string& text)
+{
+    std::vector<int> result;
+    std::stringstream stream(text);
+    std::string range;
+
+    while (std::getline(stream, range, ',')) {
+        if (range.empty() || range[0] < '0' || range[0] > '9')
+            continue;
+
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu)
+            result.push_back(cpu);
     }
-    else
+    return result;
+}
+
+std::vector<std::vector<int>> tp::component::detectNumaNodes()
+{
+    std::vector<std::vector<int>> nodes;
+
+#if defined(_WIN32)
+    ULONG highest = 0;
+    if (!GetNumaHighestNodeNumber(&highest))
+        return nodes;
+
+    for (ULONG node = 0; node <= highest; ++node) {
+        ULONGLONG mask = 0;
+        if (!GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &mask) || mask == 0)
+            continue;
+
+        std::vector<int> cpus;
+        for (int cpu = 0; cpu < 64; ++cpu) {
+            if (mask & (1ULL << cpu))
+                cpus.push_back(cpu);
+        }
+        nodes.push_back(cpus);
+    }
+#elif defined(__linux__)
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string text;
+    if (!std::getline(online, text))
+        return nodes;
+
+    for (int node : parseCpuList(text)) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        if (std::getline(file, list)) {
+            std::vector<int> cpus = parseCpuList(list);
+            if (!cpus.empty())
+                nodes.push_back(cpus);
+        }
+    }
+#endif
+
+    return nodes;
+}
+
+/**
+ * @brief Pin the calling thread to a core, best effort
+ * @brief     ,  
+ */
+static void pinCurrentThread(int cpu)
+{
+#if defined(_WIN32)
+    if (cpu < static_cast<int>(sizeof(DWORD_PTR) * 8))
+        SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu);
+#elif defined(__linux__)
+    if (cpu < CPU_SETSIZE) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#else
+    (void)cpu;
+#endif
+}
+
+namespace tp
+{
+    namespace component
     {
-        queue = std::make_unique <tp::component::PriorityQueue<std::function<void(int id)>*>>();
+        /**
+         * @brief Creates the queue of one node for a queue policy
+         * @brief       
+         */
+        template <typename Queue>
+        struct QueueFactory
+        {
+            static std::unique_ptr<Queue> create(const PoolConfig&) { return std::make_unique<Queue>(); }
+        };
+
+        template <>
+        struct QueueFactory<NormalQueue<Task>>
+        {
+            static std::unique_ptr<NormalQueue<Task>> create(const PoolConfig& config)
+            {
+                return std::make_unique<NormalQueue<Task>>(config.maxQueueSize);
+            }
+        };
+
+        template <>
+        struct QueueFactory<PriorityQueue<Task>>
+        {
+            static std::unique_ptr<PriorityQueue<Task>> create(const PoolConfig& config)
+            {
+                return std::make_unique<PriorityQueue<Task>>(config.maxQueueSize);
+            }
+        };
+
+        template <>
+        struct QueueFactory<RingQueue<Task>>
+        {
+            static std::unique_ptr<RingQueue<Task>> create(const PoolConfig& config)
+            {
+                return std::make_unique<RingQueue<Task>>(config.queueCapacity);
+            }
+        };
+
+        template <>
+        struct QueueFactory<BandedPriorityQueue<Task>>
+        {
+            static std::unique_ptr<BandedPriorityQueue<Task>> create(const PoolConfig& config)
+            {
+                return std::make_unique<BandedPriorityQueue<Task>>(config.queueCapacity);
+            }
+        };
+
+        /**
+         * @brief The type-erased pool picks the queue from TypePool
+         * @brief        TypePool
+         */
+        template <>
+        struct QueueFactory<QueueMutex<Task>>
+        {
+            static std::unique_ptr<QueueMutex<Task>> create(const PoolConfig& config)
+            {
+                if (config.typePool == TypePool::Priority)
+                {
+                    return QueueFactory<PriorityQueue<Task>>::create(config);
+                }
+                else if (config.typePool == TypePool::LockFree)
+                {
+                    return QueueFactory<RingQueue<Task>>::create(config);
+                }
+                else if (config.typePool == TypePool::BandedPriority)
+                {
+                    return QueueFactory<BandedPriorityQueue<Task>>::create(config);
+                }
+                else
+                {
+                    // For WorkStealing this is the injection queue for tasks pushed from outside the pool
+                    //  WorkStealing     ,   
+                    return QueueFactory<NormalQueue<Task>>::create(config);
+                }
+            }
+        };
     }
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::init(const PoolConfig& config)
+{
+    this->typePool = config.typePool;
+    this->config = config;
+    if (this->config.maxThreads > 0 && this->config.maxThreads < this->config.minThreads)
+        this->config.maxThreads = this->config.minThreads;
+
+    // One queue per NUMA node
+    //      NUMA
+    numNodes = config.nodes.empty() ? 1 : config.nodes.size();
+    for (size_t i = 0; i < numNodes; ++i)
+        queues.push_back(tp::component::QueueFactory<QueuePolicy>::create(config));
+    nextNode = 0;
+
+    // The first lane uses the node queues, every other lane gets a queue behind them
+    //     ,      
+    if (config.lanes.size() > 64)
+        throw std::invalid_argument("ThreadPool supports at most 64 lanes");
+    hasReserved = false;
+    for (const LaneConfig& laneConfig : config.lanes) {
+        std::unique_ptr<component::Lane> lane(new component::Lane());
+        lane->name = laneConfig.name;
+        lane->stride = (std::uint64_t(1) << 20) / std::max(1u, laneConfig.weight);
+        lane->reserved = static_cast<int>(laneConfig.reserved);
+        hasReserved = hasReserved || laneConfig.reserved > 0;
+        if (!lanes.empty())
+            queues.push_back(tp::component::QueueFactory<QueuePolicy>::create(config));
+        lanes.push_back(std::move(lane));
+    }
+
+    // A LIFO slot would let tasks overtake higher priorities, and WorkStealing has deques
+    // LIFO-       ,   WorkStealing  
+    isLifoSlot = typePool != TypePool::WorkStealing && !queues.front()->hasPriorities();
+    // Batches are not taken from priority queues for the same reason
+    //           
+    isBatching = !queues.front()->hasPriorities();
+    // A task held in a slot or a batch would escape the lane accounting
+    // ,     ,     
+    if (!lanes.empty()) {
+        isLifoSlot = false;
+        isBatching = false;
+    }
+    if (isBatching) {
+        for (size_t i = 0; i < numNodes; ++i)
+            batches.emplace_back(new component::TaskBatch());
+    }
+#ifdef TP_ENABLE_METRICS
+    queued = 0;
+#endif
+    numActive = 0;      // Workers are added by the constructor
+    numParked = 0;
     numWaiting = 0;     // No threads waiting initially
+    numSpinning = 0;    // No threads spinning initially
+    nextTimer = component::TimerWheel::never;
+    tracing = nullptr;  // Not tracing until startTrace()
+    isTimerKeeper = false;
+    numBlocked = 0;     // No producers waiting for space
+    numInFlight = 0;    // No tasks pushed yet
+    numIdleWaiters = 0;
+    groupPruneSize = 64;
+    spinCount = 0;      // Park immediately by default
+    yieldCount = 0;
+    inlineThreshold = 64;
+    maxInlineDepth = 8;
     isStop = false;     // Not stopped
     isDone = false;     // Not done
 }
 
-void tp::ThreadPool::setThread(int ind)
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::addThreads(unsigned int numThreads)
+{
+    unsigned int oldNumThread = threads.size();
+    threads.resize(numThreads);
+
+    // Configure worker threads before any of them starts
+    //        
+    for (unsigned int i = oldNumThread; i < numThreads; ++i)
+    {
+        threads[i].block.reset(new component::WorkerBlock()); // Not make_shared, which ignores CacheAligned /  make_shared,   CacheAligned
+        threads[i].node = config.nodes.empty() ? 0 : static_cast<int>(i % config.nodes.size());
+        if (typePool == TypePool::WorkStealing)
+            threads[i].deque.reset(new component::TaskDeque());
+    }
+
+    // Many workers start each other as a tree, the caller creates only the first one
+    //      ,     
+    if (numThreads >= oldNumThread + component::StartTree::minSize) {
+        component::StartTree tree(oldNumThread, numThreads);
+        setThread(oldNumThread, &tree);
+        tree.wait();
+    }
+
+    // Create the rest one by one, including those the tree failed to create
+    //    ,  ,     
+    for (unsigned int i = oldNumThread; i < numThreads; ++i) {
+        if (!threads[i].thread)
+            setThread(i);
+    }
+    numActive = numThreads;
+    updateWorkers();
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::setThread(int ind, component::StartTree* tree)
 {
-    std::shared_ptr<std::atomic<bool>> flag(threads[ind].isNotWorking);
+    std::shared_ptr<component::WorkerBlock> block(threads[ind].block);
+    std::shared_ptr<component::TaskDeque> deque(threads[ind].deque);
+    int node = threads[ind].node;
+
+    // Core for this worker, -1 if it is not pinned
+    //    , -1    
+    int cpu = -1;
+    if (!config.nodes.empty()) {
+        const std::vector<int>& cpus = config.nodes[node];
+        if (!cpus.empty())
+            cpu = cpus[(ind / config.nodes.size()) % cpus.size()];
+    }
+    else if (!config.cpus.empty()) {
+        cpu = config.cpus[ind % config.cpus.size()];
+    }
 
     // Lambda function that represents the worker thread's lifecycle
     // -,     
-    auto f = [this, ind, flag]() {
-        std::atomic<bool>& _flag = *flag;
-        std::function<void(int id)>* fun;
-        bool isPop = queue->pop(fun);
+    auto f = [this, ind, node, cpu, block, deque, tree]() {
+        std::atomic<bool>& _flag = block->isNotWorking;
+        std::atomic<bool>& _parked = block->isParked;
+
+        // Children are created before pinning, a new thread inherits the affinity of its creator
+        //    ,      
+        if (tree)
+            startChildren(ind, *tree);
+
+        // Pin before the worker touches any memory
+        //   ,     
+        if (cpu >= 0)
+            pinCurrentThread(cpu);
+
+        // Register the worker for this thread
+        //      
+        currentWorker.pool = this;
+        currentWorker.index = ind;
+        currentWorker.node = node;
+        currentWorker.deque = deque.get();
+        currentWorker.slot = isLifoSlot ? &block->slot : nullptr;
+        currentWorker.seed = static_cast<unsigned int>(ind) * 2654435761u + 1u;
+        std::vector<std::uint64_t> lanePass(lanes.size());
+        currentWorker.lanePass = lanePass.empty() ? nullptr : lanePass.data();
+#ifdef TP_ENABLE_METRICS
+        component::WorkerMetrics* metrics = &block->metrics;
+        currentWorker.metrics = metrics;
+#endif
+
+        Task task;
+        trace(TraceEvent::Dequeue);
+        bool isPop = popTask(task);
 
         // Main worker thread loop
         //    
@@ -184,48 +647,150 @@ void tp::ThreadPool::setThread(int ind)
             // Process available tasks from the queue
             //     
             while (isPop) {
-                // Smart pointer for automatic memory management
-                //      
-                std::unique_ptr<std::function<void(int id)>> func(fun);
-
-                try {
-                    // Execute the task with thread ID
-                    //     
-                    (*fun)(ind);
+                execute(task, ind);
+
+                // Busy workers keep timers on time between tasks
+                //       
+                if (isTimerDue())
+                    fireTimers();
+
+                if (_flag) {
+                    exitWorker(ind);
+                    return;  // Exit if thread should stop
                 }
-                catch (const std::exception& e) {
-                    // Handle standard exceptions gracefully
-                    //   
-                    std::cerr << "Exception in thread " << ind << ": " << e.what() << std::endl;
+                else {
+                    trace(TraceEvent::Dequeue);
+                    isPop = !_parked && popTask(task);
                 }
-                catch (...) {
-                    // Handle unknown exceptions
-                    //   
-                    std::cerr << "Unknown exception in thread " << ind << std::endl;
+            }
+
+            if (_parked) {
+                // Parked by resize(): local tasks go to the queue, the thread stays alive for a later grow
+                //  resize():     ,     
+                releaseLocal();
+                if (!parkWorker(*block)) {
+                    exitWorker(ind);
+                    return;  // Exit if the pool stops while parked
                 }
+                isPop = !_parked && popTask(task);
+                continue;
+            }
 
-                if (_flag)
-                    return;  // Exit if thread should stop
-                else
-                    isPop = queue->pop(fun);
+#ifdef TP_ENABLE_METRICS
+            // Idle time lasts from here until the next task is found
+            //        
+            std::uint64_t idleStart = component::metricsNow();
+#endif
+
+            // Poll for a while before parking
+            //        
+            if (spinForTask(task, _flag)) {
+#ifdef TP_ENABLE_METRICS
+                component::WorkerMetrics::add(metrics->idleNs, component::metricsNow() - idleStart);
+#endif
+                isPop = true;
+                continue;
             }
 
             // Wait for new tasks when queue is empty
             //      
+            trace(TraceEvent::Park);
             std::unique_lock<std::mutex> lock(mutex);
             ++numWaiting;
 
+            // Pairs with the fence in wakeOne(): either the producer sees this
+            // sleeper or the predicate below sees the new task
+            //    wakeOne():     ,
+            //      
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            // One idle worker at a time sleeps until the next timer, the others until notified
+            //         ,  -  
+            bool isKeeper = hasTimers() && !isTimerKeeper.exchange(true);
+
             // Wait for notification or condition change
             //     
-            cv.wait(lock, [this, &fun, &isPop, &_flag]() {
-                isPop = queue->pop(fun);
-                return isPop || isDone || _flag;
-                });
+            auto isWoken = [this, &task, &isPop, &_flag, &_parked, isKeeper]() {
+                // A stopping pool is drained outside the lock, every worker leaves the wait at once
+                //     ,     
+                if (isDone || _flag)
+                    return true;
+                currentWorker.isWaiting = true;
+                isPop = !_parked && popTask(task);
+                currentWorker.isWaiting = false;
+                bool isTimerWork = isKeeper ? isTimerDue() : hasTimers() && !isTimerKeeper.load();
+                return isPop || _parked || isTimerWork;
+            };
+
+            // In the elastic mode the wait ends after keepAlive without work
+            //       keepAlive  
+            bool isTimedOut = false;
+            std::chrono::steady_clock::time_point retireTime = std::chrono::steady_clock::now() + config.keepAlive;
+            while (!isWoken()) {
+                // The deadline is read again after every wake, a new timer may be earlier
+                //     ,     
+                bool isTimed = isElastic();
+                std::chrono::steady_clock::time_point until = retireTime;
+                std::int64_t next = isKeeper ? nextTimer.load(std::memory_order_relaxed) : component::TimerWheel::never;
+                if (next != component::TimerWheel::never) {
+                    std::chrono::steady_clock::time_point timerTime = component::TimerWheel::timeOf(next);
+                    until = isTimed ? std::min(until, timerTime) : timerTime;
+                    isTimed = true;
+                }
+
+                // A worker finishing the task that blocks a held-back lane wakes nobody, so that lane is polled
+                // ,  ,   ,   ,   
+                if (currentWorker.isThrottled) {
+                    std::chrono::steady_clock::time_point pollTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(1);
+                    until = isTimed ? std::min(until, pollTime) : pollTime;
+                    isTimed = true;
+                }
+
+                if (!isTimed)
+                    cv.wait(lock);
+                else
+                    cv.wait_until(lock, until);
+
+                if (isElastic() && std::chrono::steady_clock::now() >= retireTime) {
+                    isTimedOut = !isWoken();
+                    break;
+                }
+            }
 
             --numWaiting;
+            trace(TraceEvent::Unpark);
+
+            // A keeper that is not going to fire the timers itself hands them to another sleeper
+            // ,      ,     
+            if (isKeeper) {
+                isTimerKeeper = false;
+                if ((isPop || isTimedOut || _parked) && hasTimers() && numWaiting > 0)
+                    cv.notify_one();
+            }
+
+#ifdef TP_ENABLE_METRICS
+            component::WorkerMetrics::add(metrics->idleNs, component::metricsNow() - idleStart);
+#endif
 
-            if (!isPop)
+            if (!isPop) {
+                lock.unlock();
+                if (isTimerDue()) {
+                    fireTimers();
+                    continue;
+                }
+                if (isTimedOut) {
+                    retireIdle();
+                    continue;
+                }
+                if (!isDone && !_flag)
+                    continue;  // Park at the top of the loop, or take over the timers
+                if (!_flag && popTask(task)) {
+                    isPop = true;
+                    continue;  // Finish the queue before exiting
+                }
+                exitWorker(ind);
                 return;  // Exit if termination signaled
+            }
         }
         };
 
@@ -234,21 +799,1158 @@ void tp::ThreadPool::setThread(int ind)
     threads[ind].thread.reset(new std::thread(f));
 }
 
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::startChildren(int ind, component::StartTree& tree)
+{
+    for (unsigned int k = 0; k < 2; ++k) {
+        unsigned int child = tree.child(static_cast<unsigned int>(ind), k);
+        if (child == tree.last)
+            break;
+
+        try {
+            setThread(static_cast<int>(child), &tree);
+        }
+        catch (...) {
+            // The caller creates the subtree one by one and reports the error
+            //          
+            tree.countOff(tree.subtreeSize(child));
+        }
+    }
+
+    // The tree must not be touched after this, the caller may already return
+    //     ,     
+    tree.countOff(1);
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::exitWorker(int ind)
+{
+    releaseLocal();
+
+    // Workers join each other in a tree, so stop() joins only the first one
+    // and threads are released in parallel
+    //     ,  stop() 
+    //  ,    
+    std::thread* children[2] = { nullptr, nullptr };
+    {
+        std::lock_guard<std::mutex> guard(this->resizeMutex);
+        for (size_t k = 0; k < 2; ++k) {
+            size_t child = 2 * static_cast<size_t>(ind) + 1 + k;
+            if (child < threads.size())
+                children[k] = threads[child].thread.get();
+        }
+    }
+    for (std::thread* child : children) {
+        if (child && child->joinable())
+            child->join();
+    }
+}
+
+template <typename QueuePolicy>
+size_t tp::BasicThreadPool<QueuePolicy>::targetNode(int node)
+{
+    if (numNodes == 1)
+        return 0;
+
+    // Explicit hint, then the node of the calling worker, then round-robin
+    //  ,    ,   
+    if (node >= 0)
+        return static_cast<size_t>(node) % numNodes;
+    if (currentWorker.pool == this)
+        return static_cast<size_t>(currentWorker.node);
+    return nextNode.fetch_add(1, std::memory_order_relaxed) % numNodes;
+}
+
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::schedule(Task&& task, int priority, int node, bool isTry)
+{
+    size_t target = targetNode(node);
+#ifdef TP_ENABLE_METRICS
+    task.enqueueTime = component::metricsNow();
+#endif
+    tracePush(&task, 1);
+
+    // Counted before the task can be taken, so the count never drops to zero early
+    //   ,    ,      
+    numInFlight.fetch_add(1, std::memory_order_relaxed);
+
+    if (typePool == TypePool::WorkStealing && currentWorker.pool == this
+        && target == static_cast<size_t>(currentWorker.node)) {
+        // Tasks spawned by a worker go to its local deque
+        // ,   ,     
+        currentWorker.deque->push(component::arenaNew<Task>(std::move(task)));
+        countQueued(1);
+    }
+    else if (isLifoSlot && currentWorker.pool == this
+        && target == static_cast<size_t>(currentWorker.node)) {
+        // The newest task spawned by a worker takes its slot, the previous one moves to the queue
+        //        ,    
+        Task* previous = currentWorker.slot->task.exchange(component::arenaNew<Task>(std::move(task)), std::memory_order_acq_rel);
+        countQueued(1);
+        if (previous) {
+            countQueued(-1);
+            enqueue(std::move(*previous), target, priority);
+            component::arenaDelete(previous);
+        }
+    }
+    else {
+        // Queues without priorities ignore the priority
+        //     
+        if (!admit(std::move(task), target, priority, isTry))
+            return false;
+    }
+
+    wakeOne();
+    growIfBusy(target);
+    return true;
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::scheduleLane(Task&& task, size_t lane)
+{
+    if (lane == 0) {
+        schedule(std::move(task), 0);
+        return;
+    }
+    if (lane >= lanes.size())
+        throw std::out_of_range("ThreadPool lane index out of range");
+
+    // Lane tasks always go through the queue of the lane, even from a worker
+    //       ,    
+    size_t target = numNodes + lane - 1;
+#ifdef TP_ENABLE_METRICS
+    task.enqueueTime = component::metricsNow();
+#endif
+    tracePush(&task, 1);
+    numInFlight.fetch_add(1, std::memory_order_relaxed);
+    admit(std::move(task), target, 0, false);
+
+    wakeOne();
+    growIfBusy(target);
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::wakeOne()
+{
+    // Take the mutex only when someone is actually parked
+    //     -   
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (numWaiting.load(std::memory_order_relaxed) == 0)
+        return;
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->cv.notify_one();
+}
+
+/**
+ * @brief Hint the CPU that the thread is busy-waiting
+ * @brief  ,      
+ */
+static inline void cpuRelax()
+{
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+    _mm_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+    __builtin_ia32_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+    asm volatile("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::spinForTask(Task& task, std::atomic<bool>& flag)
+{
+    unsigned int spins = spinCount.load(std::memory_order_relaxed);
+    unsigned int yields = yieldCount.load(std::memory_order_relaxed);
+    if (spins == 0 && yields == 0)
+        return false;
+
+    ++numSpinning;
+    bool isPop = false;
+    for (unsigned int i = 0; i < spins + yields && !isPop; ++i) {
+        if (isDone || flag)
+            break;
+
+        if (i < spins)
+            cpuRelax();
+        else
+            std::this_thread::yield();
+
+        isPop = popTask(task);
+    }
+    --numSpinning;
+    return isPop;
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::growIfBusy(size_t node)
+{
+    // Grow only when every worker is busy and work is already waiting
+    //          
+    if (!isElastic() || numActive.load(std::memory_order_relaxed) >= config.maxThreads || numIdle() > 0)
+        return;
+
+    bool hasBacklog = !queues[node]->empty() || (node < batches.size() && !batches[node]->tasks.empty())
+        || (currentWorker.pool == this && currentWorker.deque && !currentWorker.deque->empty());
+    if (!hasBacklog)
+        return;
+
+    // Producers never wait for another resize
+    //       
+    std::unique_lock<std::mutex> guard(this->resizeMutex, std::try_to_lock);
+    if (!guard.owns_lock() || isStop || isDone)
+        return;
+
+    unsigned int numThreads = numActive;
+    if (numThreads < config.maxThreads)
+        resizeLocked(numThreads + 1);
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::retireIdle()
+{
+    std::unique_lock<std::mutex> guard(this->resizeMutex, std::try_to_lock);
+    if (!guard.owns_lock() || isStop || isDone)
+        return;
+
+    // The last active worker is parked, whichever worker timed out
+    //    ,      -
+    unsigned int numThreads = numActive;
+    if (numThreads > config.minThreads)
+        resizeLocked(numThreads - 1);
+}
+
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::parkWorker(component::WorkerBlock& block)
+{
+    trace(TraceEvent::Park);
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        ++numParked;
+        parkCv.notify_all(); // resize() waits for the excess workers / resize()   
+    }
+
+    // Each parked worker sleeps on its own condition, so resize() and stop() wake exactly the workers they need
+    //       ,  resize()  stop()    
+    // isParked changes only under parkMutex, so the flag read here is the one that ended the wait
+    // isParked    parkMutex,     ,   
+    bool isResumed;
+    {
+        std::unique_lock<std::mutex> lock(block.parkMutex);
+        block.parkCv.wait(lock, [this, &block]() { return !block.isParked || isDone || isStop; });
+        isResumed = !block.isParked;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        --numParked;
+    }
+    trace(TraceEvent::Unpark);
+
+    // Still parked means the pool is stopping
+    //     ,  
+    return isResumed;
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::scheduleBatch(std::vector<Task>& tasks)
+{
+    if (tasks.empty())
+        return;
+
+#ifdef TP_ENABLE_METRICS
+    std::uint64_t now = component::metricsNow();
+    for (auto& task : tasks)
+        task.enqueueTime = now;
+#endif
+
+    size_t node = targetNode(-1);
+    numInFlight.fetch_add(static_cast<std::int64_t>(tasks.size()), std::memory_order_relaxed);
+    if (typePool == TypePool::WorkStealing && currentWorker.pool == this) {
+        tracePush(tasks.data(), tasks.size());
+        for (auto& task : tasks)
+            currentWorker.deque->push(component::arenaNew<Task>(std::move(task)));
+        countQueued(static_cast<std::int64_t>(tasks.size()));
+    }
+    else {
+        // One queue operation for the whole batch
+        //       
+        // Leftovers are traced by schedule(), so only the pushed tasks get events here
+        //   schedule(),       
+        traceLabel(tasks.data(), tasks.size());
+        size_t pushed = queues[node]->pushBulk(tasks.data(), tasks.size());
+        traceEvents(TraceEvent::Push, pushed);
+        countQueued(static_cast<std::int64_t>(pushed));
+        if (pushed < tasks.size()) {
+            // Full ring: wake everybody so the leftovers can be pushed one by one
+            //  :  ,       
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->cv.notify_all();
+            }
+            // schedule() counts the leftovers again, so they are uncounted first in case it throws
+            // schedule()   ,       
+            finishTasks(static_cast<std::int64_t>(tasks.size() - pushed));
+            for (size_t i = pushed; i < tasks.size(); ++i)
+                schedule(std::move(tasks[i]), 0);
+            return;
+        }
+    }
+
+    // Wake no more workers than there are tasks
+    //    ,  
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (numWaiting.load(std::memory_order_relaxed) == 0) {
+        growIfBusy(node);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    size_t idle = static_cast<size_t>(numWaiting.load());
+    if (tasks.size() >= idle) {
+        this->cv.notify_all();
+    }
+    else {
+        for (size_t i = 0; i < tasks.size(); ++i)
+            this->cv.notify_one();
+    }
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::execute(Task& task, int ind)
+{
+    // The lane counted by popTask(), a task run inline by a push has none
+    // ,  popTask(),  ,   ,  
+    int lane = lanes.empty() ? -1 : std::exchange(currentWorker.lane, -1);
+
+#ifdef TP_ENABLE_METRICS
+    // Only workers record, a foreign helping thread has no counters
+    //    ,      
+    component::WorkerMetrics* metrics = currentWorker.pool == this ? currentWorker.metrics : nullptr;
+    std::uint64_t start = metrics ? component::metricsNow() : 0;
+#endif
+
+    trace(TraceEvent::Begin, task.label);
+    try {
+        // Execute the task with thread ID
+        //     
+        task(ind);
+    }
+    catch (...) {
+        handleException(ind, std::current_exception());
+    }
+    trace(TraceEvent::End, task.label);
+
+#ifdef TP_ENABLE_METRICS
+    if (metrics) {
+        std::uint64_t end = component::metricsNow();
+        std::uint64_t wait = start > task.enqueueTime ? start - task.enqueueTime : 0;
+        metrics->recordTask(wait, end - start);
+    }
+#endif
+
+    // Release captured state right after execution
+    //      
+    task.reset();
+    if (lane >= 0)
+        lanes[lane]->numRunning.fetch_sub(1, std::memory_order_release);
+    finishTasks(1);
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::handleException(int ind, std::exception_ptr exception)
+{
+    std::shared_ptr<const ExceptionHandler> handler = std::atomic_load(&exceptionHandler);
+    if (handler) {
+        try {
+            (*handler)(ind, exception);
+        }
+        catch (...) {
+            // A throwing handler must not terminate the worker
+            //       
+        }
+        return;
+    }
+
+    try {
+        std::rethrow_exception(exception);
+    }
+    catch (const std::exception& e) {
+        // Handle standard exceptions gracefully
+        //   
+        std::cerr << "Exception in thread " << ind << ": " << e.what() << std::endl;
+    }
+    catch (...) {
+        // Handle unknown exceptions
+        //   
+        std::cerr << "Unknown exception in thread " << ind << std::endl;
+    }
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::enqueue(Task&& task, size_t node, int priority)
+{
+    while (!queues[node]->push(std::move(task), priority)) {
+        // Bounded queue is full: a worker runs the task itself so the pool cannot
+        // deadlock, an external producer waits for free space
+        //   :     , 
+        //   ,     
+        if (currentWorker.pool == this) {
+            execute(task, currentWorker.index);
+            return;
+        }
+        std::this_thread::yield();
+    }
+    countQueued(1);
+}
+
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::admit(Task&& task, size_t node, int priority, bool isTry)
+{
+    if (queues[node]->push(std::move(task), priority)) {
+        countQueued(1);
+        return true;
+    }
+    if (isTry) {
+        finishTasks(1);
+        return false;
+    }
+
+    // The queue is full. Workers never wait or fail, see OverflowPolicy
+    //  .        , . OverflowPolicy
+    bool isWorker = currentWorker.pool == this;
+    OverflowPolicy policy = config.overflow;
+    if (policy == OverflowPolicy::CallerRuns || (isWorker && policy != OverflowPolicy::DropOldest)) {
+        execute(task, isWorker ? currentWorker.index : -1);
+        return true;
+    }
+
+    if (policy == OverflowPolicy::DropOldest) {
+        Task dropped;
+        while (!queues[node]->push(std::move(task), priority)) {
+            // Another producer may take the freed place first
+            //       
+            if (queues[node]->evict(dropped)) {
+                countQueued(-1);
+                dropped.reset();
+                finishTasks(1);
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+        countQueued(1);
+        return true;
+    }
+
+    if (policy == OverflowPolicy::Reject) {
+        finishTasks(1);
+        throw QueueFullError("ThreadPool queue is full");
+    }
+    if (!waitForSpace(task, node, priority)) {
+        finishTasks(1);
+        throw QueueFullError(isDone || isStop ? "ThreadPool stopped while waiting for queue space" : "ThreadPool queue stayed full for pushTimeout");
+    }
+    return true;
+}
+
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::waitForSpace(Task& task, size_t node, int priority)
+{
+    // Consumers read numBlocked without a fence, so a producer never sleeps
+    // longer than one slice on a missed notification
+    //   numBlocked  ,   
+    //       
+    const std::chrono::milliseconds slice(1);
+    bool isTimed = config.pushTimeout.count() > 0;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + config.pushTimeout;
+
+    ++numBlocked;
+    bool isPushed = false;
+    while (!isDone && !isStop) {
+        if (queues[node]->push(std::move(task), priority)) {
+            isPushed = true;
+            break;
+        }
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (isTimed && now >= deadline)
+            break;
+
+        std::unique_lock<std::mutex> lock(this->spaceMutex);
+        spaceCv.wait_until(lock, isTimed ? std::min(now + slice, deadline) : now + slice);
+    }
+    --numBlocked;
+
+    if (isPushed)
+        countQueued(1);
+    return isPushed;
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::notifySpace(size_t count)
+{
+    if (numBlocked.load(std::memory_order_relaxed) == 0)
+        return;
+
+    std::unique_lock<std::mutex> lock(this->spaceMutex);
+    if (count > 1)
+        spaceCv.notify_all();
+    else
+        spaceCv.notify_one();
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::finishTasks(std::int64_t count)
+{
+    if (numInFlight.fetch_sub(count, std::memory_order_acq_rel) != count)
+        return;
+
+    // Pairs with the fence in waitIdle(): either the waiter is seen here or it sees zero
+    //    waitIdle():    ,    
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (numIdleWaiters.load(std::memory_order_relaxed) == 0)
+        return;
+
+    std::unique_lock<std::mutex> lock(this->idleMutex);
+    idleCv.notify_all();
+}
+
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::isInlineRun() const
+{
+    if (currentWorker.inlineDepth >= maxInlineDepth.load(std::memory_order_relaxed) || isDone || isStop)
+        return false;
+    if (numWaiting.load(std::memory_order_relaxed) + numSpinning.load(std::memory_order_relaxed) > 0)
+        return false;
+
+    // With every worker busy, the tasks in flight beyond one per worker are queued
+    //    ,        
+    std::int64_t queued = numInFlight.load(std::memory_order_relaxed) - static_cast<std::int64_t>(numActive.load(std::memory_order_relaxed));
+    return queued > static_cast<std::int64_t>(inlineThreshold.load(std::memory_order_relaxed));
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::runInline(Task&& task)
+{
+    // The task keeps exceptions in its future, so the depth is always restored
+    //      future,    
+    ++currentWorker.inlineDepth;
+    task(currentWorker.pool == this ? currentWorker.index : -1);
+    --currentWorker.inlineDepth;
+}
+
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::popTask(Task& task)
+{
+    if (lanes.empty())
+        return popDefault(task);
+    return popLane(task);
+}
+
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::popDefault(Task& task)
+{
+    // Own slot and deque first (LIFO), then the shared queue, then other workers
+    //      (LIFO),   ,   
+    bool isWorker = currentWorker.pool == this;
+    Task* box = nullptr;
+    if (isWorker && ((currentWorker.slot && (box = currentWorker.slot->take()) != nullptr)
+        || (currentWorker.deque && currentWorker.deque->pop(box)))) {
+        task = std::move(*box);
+        component::arenaDelete(box);
+        countQueued(-1);
+        return true;
+    }
+
+    // Other NUMA nodes are visited only after the own node is empty
+    //   NUMA      
+    size_t home = isWorker ? static_cast<size_t>(currentWorker.node) : 0;
+    for (size_t i = 0; i < numNodes; ++i) {
+        size_t node = (home + i) % numNodes;
+        if (popQueue(task, node) || (typePool == TypePool::WorkStealing && stealTask(task, node))) {
+            countQueued(-1);
+            return true;
+        }
+    }
+
+    if (isLifoSlot && stealSlot(task)) {
+        countQueued(-1);
+        return true;
+    }
+    return false;
+}
+
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::popLane(Task& task)
+{
+    // Workers visit the lanes by the smallest stride pass, other threads in order
+    //       ,   -  
+    bool isWorker = currentWorker.pool == this;
+    std::uint64_t* pass = isWorker ? currentWorker.lanePass : nullptr;
+    size_t numLanes = lanes.size();
+    std::uint64_t visited = 0;
+    bool isThrottled = false;
+
+    for (size_t round = 0; round < numLanes; ++round) {
+        size_t lane = numLanes;
+        for (size_t i = 0; i < numLanes; ++i) {
+            if (!((visited >> i) & 1) && (lane == numLanes || (pass && pass[i] < pass[lane])))
+                lane = i;
+        }
+        visited |= std::uint64_t(1) << lane;
+
+        if (!enterLane(lane)) {
+            isThrottled = true;
+            continue;
+        }
+        bool isPop = lane == 0 ? popDefault(task) : popQueue(task, numNodes + lane - 1);
+        if (!isPop) {
+            lanes[lane]->numRunning.fetch_sub(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (lane != 0)
+            countQueued(-1);
+
+        currentWorker.lane = static_cast<int>(lane);
+        if (pass) {
+            // Lanes passed over without work do not save up a share for later
+            // ,   ,     
+            std::uint64_t now = pass[lane];
+            for (size_t i = 0; i < numLanes; ++i) {
+                if (((visited >> i) & 1) && pass[i] < now)
+                    pass[i] = now;
+            }
+            pass[lane] = now + lanes[lane]->stride;
+            currentWorker.isThrottled = false;
+        }
+        return true;
+    }
+
+    if (isWorker)
+        currentWorker.isThrottled = isThrottled;
+    return false;
+}
+
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::enterLane(size_t lane)
+{
+    // Counted first, so two workers cannot both slip past a reservation
+    //  ,        
+    std::atomic<int>& running = lanes[lane]->numRunning;
+    running.fetch_add(1, std::memory_order_seq_cst);
+    if (!hasReserved || isDone)
+        return true;
+
+    // The other lanes together must leave every reserving lane its workers
+    //          
+    int total = 0;
+    for (auto& state : lanes)
+        total += state->numRunning.load(std::memory_order_seq_cst);
+    int numWorkers = static_cast<int>(numActive.load(std::memory_order_relaxed));
+    for (size_t i = 0; i < lanes.size(); ++i) {
+        int reserved = lanes[i]->reserved;
+        if (i == lane || reserved == 0)
+            continue;
+        int others = total - lanes[i]->numRunning.load(std::memory_order_relaxed);
+        if (others > std::max(1, numWorkers - reserved)) {
+            running.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::popQueue(Task& task, size_t node)
+{
+    if (node >= batches.size()) {
+        if (!queues[node]->pop(task))
+            return false;
+        notifySpace(1);
+        return true;
+    }
+
+    // Tasks stay counted as queued until they are taken from the batch
+    //     ,      
+    component::TaskBatch& batch = *batches[node];
+    if (batch.tasks.pop(task))
+        return true;
+
+    // Waiting for a refill in progress keeps the FIFO order: the refilled
+    // tasks are older than anything left in the queue
+    //      FIFO:  
+    //  ,    
+    Task taken[component::TaskBatch::capacity];
+    size_t n;
+    {
+        std::lock_guard<std::mutex> lock(batch.refillMutex);
+        if (batch.tasks.pop(task))
+            return true;
+
+        size_t requested = batch.limit;
+        n = queues[node]->popBatch(taken, requested);
+        batch.adapt(n, requested);
+        // A cell stays taken until a pop of the previous lap has moved its task out
+        //   ,        
+        for (size_t i = 1; i < n; ++i) {
+            while (!batch.tasks.push(std::move(taken[i])))
+                std::this_thread::yield();
+        }
+    }
+    if (n == 0)
+        return false;
+    notifySpace(n);
+    task = std::move(taken[0]);
+
+    // Sleeping workers may take the rest of the batch, a worker going to sleep already holds the mutex
+    //      ,     
+    if (n > 1) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (numWaiting.load(std::memory_order_relaxed) > 0) {
+            std::unique_lock<std::mutex> lock;
+            if (!currentWorker.isWaiting)
+                lock = std::unique_lock<std::mutex>(this->mutex);
+            if (n > 2)
+                cv.notify_all();
+            else
+                cv.notify_one();
+        }
+    }
+    return true;
+}
+
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::stealTask(Task& task, size_t node)
+{
+    std::shared_ptr<component::DequeList> nodes = std::atomic_load(&deques);
+    if (!nodes || node >= nodes->size() || (*nodes)[node].empty())
+        return false;
+    const std::vector<std::shared_ptr<component::TaskDeque>>* list = &(*nodes)[node];
+
+    // Start from a random victim and try every deque once
+    //          
+    unsigned int& seed = currentWorker.seed;
+    if (seed == 0)
+        seed = 0x9E3779B9u;
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    Task* box;
+    size_t n = list->size();
+    size_t start = seed % n;
+    for (size_t i = 0; i < n; ++i) {
+        component::TaskDeque* victim = (*list)[(start + i) % n].get();
+        if (victim != currentWorker.deque && victim->steal(box)) {
+            task = std::move(*box);
+            component::arenaDelete(box);
+#ifdef TP_ENABLE_METRICS
+            if (currentWorker.pool == this)
+                component::WorkerMetrics::add(currentWorker.metrics->steals, 1);
+#endif
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::stealSlot(Task& task)
+{
+    std::shared_ptr<component::SlotList> list = std::atomic_load(&slots);
+    if (!list || list->empty())
+        return false;
+
+    // Start after the own slot so thieves spread over the workers
+    //    ,     
+    size_t n = list->size();
+    size_t start = currentWorker.pool == this ? static_cast<size_t>(currentWorker.index) + 1 : 0;
+    for (size_t i = 0; i < n; ++i) {
+        Task* box = (*list)[(start + i) % n]->take();
+        if (box) {
+            task = std::move(*box);
+            component::arenaDelete(box);
+#ifdef TP_ENABLE_METRICS
+            if (currentWorker.pool == this)
+                component::WorkerMetrics::add(currentWorker.metrics->steals, 1);
+#endif
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::releaseLocal()
+{
+    size_t node = static_cast<size_t>(currentWorker.node);
+    bool isMoved = false;
+
+    // Hand remaining local tasks over to the shared queue
+    //       
+    Task* box = currentWorker.slot ? currentWorker.slot->take() : nullptr;
+    if (box) {
+        countQueued(-1);
+        enqueue(std::move(*box), node);
+        component::arenaDelete(box);
+        isMoved = true;
+    }
+
+    component::TaskDeque* deque = currentWorker.deque;
+    while (deque && deque->pop(box)) {
+        countQueued(-1);
+        enqueue(std::move(*box), node);
+        component::arenaDelete(box);
+        isMoved = true;
+    }
+
+    if (!isMoved)
+        return;
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    cv.notify_all();
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::updateWorkers()
+{
+    // Readers load these snapshots without the pool mutex
+    //       
+#ifdef TP_ENABLE_METRICS
+    auto counters = std::make_shared<std::vector<std::shared_ptr<component::WorkerMetrics>>>();
+    for (auto& thread : threads)
+        counters->push_back(std::shared_ptr<component::WorkerMetrics>(thread.block, &thread.block->metrics));
+    std::atomic_store(&metrics, counters);
+#endif
+
+    if (isLifoSlot) {
+        auto slotList = std::make_shared<component::SlotList>();
+        for (unsigned int i = 0, n = numActive; i < n; ++i)
+            slotList->push_back(std::shared_ptr<component::TaskSlot>(threads[i].block, &threads[i].block->slot));
+        std::atomic_store(&slots, slotList);
+    }
+
+    if (typePool != TypePool::WorkStealing)
+        return;
+
+    // Parked workers hand their tasks over and are not worth stealing from
+    //          
+    auto list = std::make_shared<component::DequeList>(numNodes);
+    for (unsigned int i = 0, n = numActive; i < n; ++i)
+        (*list)[threads[i].node].push_back(threads[i].deque);
+
+    std::atomic_store(&deques, list);
+}
+
+template <typename QueuePolicy>
+tp::PoolStats tp::BasicThreadPool<QueuePolicy>::stats() const
+{
+    PoolStats result;
+
+#ifdef TP_ENABLE_METRICS
+    result.isEnabled = true;
+
+    std::int64_t depth = queued.load(std::memory_order_relaxed);
+    result.queueDepth = depth > 0 ? static_cast<size_t>(depth) : 0;
+
+    std::shared_ptr<std::vector<std::shared_ptr<component::WorkerMetrics>>> counters = std::atomic_load(&metrics);
+    if (counters) {
+        for (auto& worker : *counters)
+            worker->collect(result);
+    }
+#endif
+
+    return result;
+}
+
+// TIMERS
+// 
+
+template <typename QueuePolicy>
+tp::TimerHandle tp::BasicThreadPool<QueuePolicy>::addTimer(std::unique_ptr<component::TimerEntry> entry)
+{
+    entry->state = std::make_shared<component::TimerState>();
+    TimerHandle handle(entry->state);
+
+    bool isEarlier = false;
+    {
+        std::lock_guard<std::mutex> guard(this->timerMutex);
+        if (isStop || isDone) {
+            entry->state->status = component::TimerState::Cancelled;
+            return handle;
+        }
+
+        timers.add(entry.get());
+        std::int64_t deadline = entry.release()->deadline;
+        if (deadline < nextTimer.load(std::memory_order_relaxed)) {
+            nextTimer.store(deadline, std::memory_order_relaxed);
+            isEarlier = true;
+        }
+    }
+
+    // The keeper has to shorten its sleep, or a sleeper has to become the keeper
+    //    ,      
+    if (isEarlier) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (numWaiting.load(std::memory_order_relaxed) > 0) {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            cv.notify_all();
+        }
+    }
+    return handle;
+}
+
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::isTimerDue() const
+{
+    // Pools without timers never read the clock
+    //       
+    std::int64_t deadline = nextTimer.load(std::memory_order_relaxed);
+    return deadline != component::TimerWheel::never && deadline <= component::TimerWheel::now();
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::fireTimers()
+{
+    std::vector<Task> ready;
+    {
+        // Another worker is already firing them
+        //     
+        std::unique_lock<std::mutex> guard(this->timerMutex, std::try_to_lock);
+        if (!guard.owns_lock())
+            return;
+
+        std::int64_t now = component::TimerWheel::now();
+        component::TimerEntry* entry = timers.advance(now);
+        while (entry) {
+            std::unique_ptr<component::TimerEntry> due(entry);
+            entry = entry->next;
+
+            if (due->period == 0) {
+                int status = component::TimerState::Pending;
+                if (due->state->status.compare_exchange_strong(status, component::TimerState::Fired))
+                    ready.push_back(std::move(due->task));
+                continue;
+            }
+
+            if (due->state->status.load() != component::TimerState::Pending)
+                continue;
+
+            std::shared_ptr<std::function<void(int)>> body = due->body;
+            ready.push_back(Task([body](int id) { (*body)(id); }));
+
+            // Runs missed while nobody serviced the wheel are skipped
+            // ,      , 
+            std::int64_t missed = (now - due->deadline) / due->period + 1;
+            due->deadline += missed * due->period;
+            timers.add(due.release());
+        }
+        nextTimer.store(timers.next(), std::memory_order_relaxed);
+    }
+
+    for (Task& task : ready)
+        schedule(std::move(task), 0, -1);
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::clearTimers()
+{
+    std::lock_guard<std::mutex> guard(this->timerMutex);
+    timers.clear();
+    nextTimer.store(component::TimerWheel::never, std::memory_order_relaxed);
+}
+
+// TRACING
+// 
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::startTrace(size_t capacity)
+{
+    std::lock_guard<std::mutex> guard(this->traceMutex);
+
+    // A run is never freed early, a hook may still hold it after stopTrace()
+    //      ,      stopTrace()
+    if (traceSessions.empty() || traceSessions.back()->ringCapacity() != capacity) {
+        size_t numWorkers = std::max<size_t>(numActive.load(std::memory_order_relaxed), config.maxThreads);
+        traceSessions.push_back(std::unique_ptr<component::TraceSession>(new component::TraceSession(numWorkers, capacity)));
+    }
+    tracing.store(traceSessions.back().get(), std::memory_order_release);
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::flushTrace(std::ostream& out)
+{
+    std::lock_guard<std::mutex> guard(this->traceMutex);
+    if (traceSessions.empty()) {
+        out << "{\"traceEvents\":[]}\n";
+        return;
+    }
+    traceSessions.back()->write(out);
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::trace(TraceEvent event, const char* label)
+{
+    // The only cost while tracing is off
+    //  ,   
+    component::TraceSession* session = tracing.load(std::memory_order_acquire);
+    if (session)
+        session->add(event, currentWorker.pool == this ? currentWorker.index : -1, label);
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::tracePush(Task* tasks, size_t count)
+{
+    component::TraceSession* session = tracing.load(std::memory_order_acquire);
+    if (!session)
+        return;
+
+    traceLabel(tasks, count);
+    traceEvents(TraceEvent::Push, count);
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::traceLabel(Task* tasks, size_t count)
+{
+    if (!tracing.load(std::memory_order_acquire))
+        return;
+
+    const char* label = TraceLabel::current();
+    for (size_t i = 0; i < count; ++i)
+        tasks[i].label = label;
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::traceEvents(TraceEvent event, size_t count)
+{
+    component::TraceSession* session = tracing.load(std::memory_order_acquire);
+    if (!session)
+        return;
+
+    const char* label = TraceLabel::current();
+    int worker = currentWorker.pool == this ? currentWorker.index : -1;
+    for (size_t i = 0; i < count; ++i)
+        session->add(event, worker, label);
+}
+
+// CANCELLATION
+// 
+
+template <typename QueuePolicy>
+tp::CancellationToken tp::BasicThreadPool<QueuePolicy>::groupToken(std::uint64_t group)
+{
+    std::lock_guard<std::mutex> guard(this->groupMutex);
+    std::shared_ptr<component::CancellationState> state = groups[group].lock();
+    if (state)
+        return CancellationToken(std::move(state));
+
+    CancellationToken token;
+    groups[group] = token.state;
+
+    // Groups whose tokens are all gone are erased once the map has doubled
+    // ,    , ,   
+    if (groups.size() >= groupPruneSize) {
+        for (auto it = groups.begin(); it != groups.end();) {
+            if (it->second.expired())
+                it = groups.erase(it);
+            else
+                ++it;
+        }
+        groupPruneSize = std::max<size_t>(64, groups.size() * 2);
+    }
+    return token;
+}
+
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::cancelGroup(std::uint64_t group)
+{
+    std::shared_ptr<component::CancellationState> state;
+    {
+        std::lock_guard<std::mutex> guard(this->groupMutex);
+        auto it = groups.find(group);
+        if (it == groups.end())
+            return false;
+        state = it->second.lock();
+        groups.erase(it);
+    }
+
+    if (!state)
+        return false;
+    CancellationToken(std::move(state)).cancel();
+    return true;
+}
+
 // TASK OPERATIONS
 //   
 
-std::function<void(int)> tp::ThreadPool::pop()
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::runPendingTask()
 {
-    std::function<void(int id)>* fun = nullptr;
-    queue->pop(fun);
+    Task task;
+    if (!popTask(task))
+        return false;
+
+    execute(task, currentWorker.pool == this ? currentWorker.index : -1);
+    return true;
+}
 
-    // Smart pointer for automatic cleanup
-    //     
-    std::unique_ptr<std::function<void(int id)>> func(fun);
+template <typename QueuePolicy>
+size_t tp::BasicThreadPool<QueuePolicy>::lane(const std::string& name) const
+{
+    for (size_t i = 0; i < lanes.size(); ++i) {
+        if (lanes[i]->name == name)
+            return i;
+    }
+    throw std::out_of_range("ThreadPool has no lane named " + name);
+}
+
+template <typename QueuePolicy>
+bool tp::BasicThreadPool<QueuePolicy>::isWorkerThread() const
+{
+    return currentWorker.pool == this;
+}
+
+template <typename QueuePolicy>
+void tp::BasicThreadPool<QueuePolicy>::setExceptionHandler(ExceptionHandler handler)
+{
+    std::shared_ptr<const ExceptionHandler> ptr;
+    if (handler)
+        ptr = std::make_shared<const ExceptionHandler>(std::move(handler));
+    std::atomic_store(&exceptionHandler, ptr);
+}
+
+template <typename QueuePolicy>
+std::function<void(int)> tp::BasicThreadPool<QueuePolicy>::pop()
+{
+    Task task;
     std::function<void(int)> f;
+    if (!popTask(task))
+        return f;
 
-    if (fun)
-        f = *fun;
+    // The task leaves the pool here, so its lane and in-flight counts are released as in execute()
+    //    ,       ,   execute()
+    int lane = lanes.empty() ? -1 : std::exchange(currentWorker.lane, -1);
+    if (lane >= 0)
+        lanes[lane]->numRunning.fetch_sub(1, std::memory_order_release);
+    finishTasks(1);
+
+    // std::function needs a copyable target, so the task is shared
+    // std::function   ,   
+    if (task) {
+        auto shared = std::make_shared<Task>(std::move(task));
+        f = [shared](int id) { (*shared)(id); };
+    }
 
     return f;
-}
\ No newline at end of file
+}
+
+// The type-erased pool and pools with the built-in queues
+//         
+template class tp::BasicThreadPool<tp::component::QueueMutex<tp::Task>>;
+template class tp::BasicThreadPool<tp::component::NormalQueue<tp::Task>>;
+template class tp::BasicThreadPool<tp::component::PriorityQueue<tp::Task>>;
+template class tp::BasicThreadPool<tp::component::RingQueue<tp::Task>>;
+template class tp::BasicThreadPool<tp::component::BandedPriorityQueue<tp::Task>>;
\ No newline at end of file
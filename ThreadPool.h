@@ -3,19 +3,144 @@
 
 #include <thread>
 #include <atomic>
+#include <chrono>
 #include <vector>
 #include <functional>
 #include <memory>
 #include <exception>
+#include <stdexcept>
 #include <future>
 #include <mutex>
 #include <condition_variable>
+#include <type_traits>
+#include <unordered_map>
+#include <string>
+#include <algorithm>
+#include <utility>
 #include "QueueMutex.h"
+#include "Task.h"
+#include "TaskAllocator.h"
+#include "Metrics.h"
+#include "WorkStealingDeque.h"
+#include "TimerWheel.h"
+#include "Cancellation.h"
+#include "Trace.h"
+
+// Coroutine support is enabled when the compiler implements C++20 coroutines
+//   ,     C++20
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define TP_HAS_COROUTINES 1
+#endif
+#endif
 
 namespace tp
 {
     namespace component
     {
+        using TaskDeque = WorkStealingDeque<Task*>; // Per-worker deque of boxed tasks /     
+        using DequeList = std::vector<std::vector<std::shared_ptr<TaskDeque>>>; // Deques grouped by NUMA node / ,    NUMA
+
+        /**
+         * @brief Single-task LIFO slot of a worker
+         * @brief  LIFO-  
+         *
+         * The newest task a worker spawns waits here instead of in the shared
+         * queue, so pushing it takes one atomic exchange and the task usually
+         * runs next on the same core. Idle threads may take it with an exchange.
+         *
+         *   ,   ,  ,   
+         *  ,    -   , 
+         *        . 
+         *     .
+         */
+        struct alignas(64) TaskSlot
+        {
+            std::atomic<Task*> task{ nullptr }; // Boxed task or nullptr /    nullptr
+
+            /**
+             * @brief Take the task out of the slot
+             * @brief    
+             *
+             * @return Boxed task, nullptr if the slot is empty /  , nullptr   
+             */
+            Task* take()
+            {
+                // Reading first keeps empty slots shared between caches
+                //        
+                if (this->task.load(std::memory_order_relaxed) == nullptr)
+                    return nullptr;
+                return this->task.exchange(nullptr, std::memory_order_acq_rel);
+            }
+        };
+
+        using SlotList = std::vector<std::shared_ptr<TaskSlot>>; // Slots of the active workers /    
+
+        /**
+         * @brief Tasks taken from the queue of a node in one batch, shared by all workers
+         * @brief ,      ,    
+         *
+         * A worker that finds the batch empty refills it from the queue and
+         * runs the first task at once. Every thread takes the rest in queue
+         * order, so tasks still start in FIFO order and a task that blocks on
+         * one batched behind it cannot strand it. The next batch size doubles
+         * while batches come back full and falls to the number found
+         * otherwise, so a shallow queue is still taken one task at a time.
+         *
+         * ,   ,      
+         *   .       
+         * ,   -    FIFO, 
+         * ,       ,   
+         * .    ,   
+         * ,      ,  
+         *  -    .
+         */
+        struct TaskBatch : CacheAligned
+        {
+            static constexpr size_t capacity = 16; // Largest batch /  
+
+            RingQueue<Task> tasks{ 2 * capacity }; // Rest of the last batch, room for pops in flight /   ,    
+            std::mutex refillMutex;                // One thread refills at a time /     
+            size_t limit = 1;                      // Size of the next batch, under refillMutex /   ,  refillMutex
+
+            /**
+             * @brief Adjust the next batch size after n of requested tasks were found
+             * @brief    ,   n  requested 
+             */
+            void adapt(size_t n, size_t requested)
+            {
+                if (n == requested)
+                    this->limit = 2 * requested < capacity ? 2 * requested : capacity;
+                else
+                    this->limit = n > 1 ? n : 1;
+            }
+        };
+
+        /**
+         * @brief State of one worker in a single cache-aligned allocation
+         * @brief         - 
+         *
+         * The flags the pool sets for the worker share a line that only this
+         * worker polls. The slot, which other threads probe, and the counters
+         * start lines of their own, so no two workers ever write to one line.
+         *
+         * ,    ,  ,  
+         *   . ,    ,  
+         *   ,       
+         *  .
+         */
+        struct alignas(64) WorkerBlock : CacheAligned
+        {
+            std::atomic<bool> isNotWorking{ false }; // Worker must exit /   
+            std::atomic<bool> isParked{ false };     // Worker is parked by resize() /   resize()
+            TaskSlot slot;                           // LIFO slot (queues without priorities) / LIFO- (  )
+            std::mutex parkMutex;                    // Guards isParked and the wait of the parked worker /  isParked    
+            std::condition_variable parkCv;          // The worker parked by resize() sleeps here /   ,  resize()
+#ifdef TP_ENABLE_METRICS
+            WorkerMetrics metrics;                   // Counters of the worker /   
+#endif
+        };
 
         /**
          * @brief Structure representing a single thread in the pool
@@ -23,10 +148,392 @@ namespace tp
          */
         struct SingThread
         {
-            std::unique_ptr<std::thread> thread;          // Thread object /  
-            std::shared_ptr<std::atomic<bool>> isNotWorking; // Flag indicating if thread is working /   
+            std::unique_ptr<std::thread> thread;  // Thread object /  
+            std::shared_ptr<WorkerBlock> block;   // Flags, slot and counters / ,   
+            std::shared_ptr<TaskDeque> deque;     // Local deque (WorkStealing only) /   ( WorkStealing)
+            int node = 0;                         // NUMA node of the worker /  NUMA  
+        };
+
+        /**
+         * @brief Workers started together as a binary tree
+         * @brief  ,      
+         *
+         * The caller starts the first worker of the range and every worker
+         * starts the next two before it takes tasks, so a large pool runs after
+         * about log2(n) thread creations on the caller's path instead of n.
+         * Each worker counts itself off; a child that could not be created is
+         * counted off with its whole subtree and left to the caller.
+         *
+         *      ,   
+         *     ,   ,  
+         *     log2(n)    
+         *    n.     ; ,
+         *    ,      
+         *   .
+         */
+        struct StartTree
+        {
+            static constexpr unsigned int minSize = 8; // Fewer new workers are started one by one /       
+
+            StartTree(unsigned int first, unsigned int last) : first(first), last(last), numPending(last - first) {}
+
+            /**
+             * @brief Child k (0 or 1) of a worker, last if there is none
+             * @brief  k (0  1) , last   
+             */
+            unsigned int child(unsigned int ind, unsigned int k) const
+            {
+                unsigned int offset = 2 * (ind - this->first) + 1 + k;
+                return offset < this->last - this->first ? this->first + offset : this->last;
+            }
+
+            /**
+             * @brief Number of workers in the subtree of a worker
+             * @brief     
+             */
+            unsigned int subtreeSize(unsigned int ind) const
+            {
+                unsigned int size = 0;
+                size_t count = this->last - this->first;
+                for (size_t low = ind - this->first, high = low; low < count; low = 2 * low + 1, high = 2 * high + 2)
+                    size += static_cast<unsigned int>(std::min(high, count - 1) - low + 1);
+                return size;
+            }
+
+            void countOff(unsigned int count)
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->numPending -= count;
+                if (this->numPending == 0)
+                    this->cv.notify_all();
+            }
+
+            void wait()
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->cv.wait(lock, [this]() { return this->numPending == 0; });
+            }
+
+            const unsigned int first; // First worker of the range /   
+            const unsigned int last;  // Past the last worker /   
+
+        private:
+            std::mutex mutex;
+            std::condition_variable cv;
+            unsigned int numPending;  // Workers not counted off yet /    
+        };
+
+        /**
+         * @brief Per-thread information about the pool worker running on it
+         * @brief      ,   
+         */
+        struct WorkerContext
+        {
+            const void* pool = nullptr;     // Owning pool, nullptr for foreign threads / -, nullptr   
+            int index = -1;                 // Worker index /   
+            int node = 0;                   // NUMA node of the worker /  NUMA  
+            TaskDeque* deque = nullptr;     // Local deque of the worker /    
+            TaskSlot* slot = nullptr;       // LIFO slot of the worker / LIFO-  
+            unsigned int seed = 0;          // Random state for victim selection /     
+            std::uint64_t* lanePass = nullptr; // Stride pass of every lane /      
+            int lane = -1;                  // Lane of the task taken last, until it runs /       
+            bool isThrottled = false;       // The last pop skipped a lane for a reservation /     - 
+            unsigned int inlineDepth = 0;   // Nested tasks run by pushOrRun() /  ,  pushOrRun()
+            bool isWaiting = false;         // Pops under the pool mutex while going to sleep /      
+#ifdef TP_ENABLE_METRICS
+            WorkerMetrics* metrics = nullptr; // Counters of the worker /   
+#endif
+        };
+
+        /**
+         * @brief Scheduling state of one lane
+         * @brief    
+         */
+        struct Lane
+        {
+            std::string name;           // Name from LaneConfig /   LaneConfig
+            std::uint64_t stride = 0;   // Pass added per task, inverse to the weight /    ,  
+            int reserved = 0;           // Workers the other lanes leave free / ,     
+            std::atomic<int> numRunning{ 0 }; // Tasks of the lane being run /   
+        };
+
+        /**
+         * @brief Promise whose shared state and result live in the slab arena
+         * @brief Promise,        -
+         */
+        template <typename R>
+        std::promise<R> makePromise()
+        {
+            return std::promise<R>(std::allocator_arg, ArenaAllocator<char>());
+        }
+
+        /**
+         * @brief Run fn(id) and store its result or exception in the promise
+         * @brief  fn(id)       promise
+         */
+        template <typename R, typename Fn>
+        void fulfill(std::promise<R>& promise, Fn& fn, int id)
+        {
+            try {
+                promise.set_value(fn(id));
+            }
+            catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        }
+
+        template <typename Fn>
+        void fulfill(std::promise<void>& promise, Fn& fn, int id)
+        {
+            try {
+                fn(id);
+                promise.set_value();
+            }
+            catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        }
+    }
+
+#ifdef TP_HAS_COROUTINES
+    namespace component
+    {
+        /**
+         * @brief Awaitable returned by ThreadPool::schedule()
+         * @brief  ,  ThreadPool::schedule()
+         *
+         * Suspends the coroutine and submits a task that resumes it on a
+         * worker. A stopped pool would never run that task and a full one may
+         * reject it, so the coroutine then continues on the current thread.
+         * A resuming task the pool destroys unrun (DropOldest, stop()) still
+         * resumes the coroutine, on the thread that dropped it, so the frame
+         * is never leaked.
+         *
+         *     ,   
+         *  .       , 
+         *    ,     
+         *    .  , 
+         *    (DropOldest, stop()),   
+         *   ,  ,    
+         * .
+         */
+        template <typename Pool>
+        class ScheduleAwaiter
+        {
+        public:
+            ScheduleAwaiter(Pool& pool, int priority) : pool(pool), priority(priority) {}
+
+            bool await_ready() const noexcept { return false; }
+
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                if (this->pool.isStopped())
+                    return false;
+
+                this->handle = handle;
+                try {
+                    this->pool.submit(this->priority, [ticket = Ticket(this)](int) mutable { ticket.release(); });
+                }
+                catch (...) {
+                    // A rejected task is left to the current thread as well
+                    //      
+                    return false;
+                }
+
+                // The task may have been run or dropped before submit() returned
+                //          submit()
+                return this->state.exchange(State::Suspended, std::memory_order_acq_rel) == State::Submitting;
+            }
+
+            void await_resume() const noexcept {}
+
+        private:
+            enum class State
+            {
+                Submitting, // await_suspend() has not returned yet / await_suspend()    
+                Suspended,  // The coroutine waits for the task /   
+                Taken       // The task has run or was dropped /    
+            };
+
+            /**
+             * @brief TaskTicket actions for the resuming task: the coroutine is resumed either way
+             * @brief  TaskTicket   :     
+             *
+             * If await_suspend() is still running, it is left to continue the
+             * coroutine inline; a throwing submit() thus never resumes it twice.
+             *
+             *  await_suspend()  ,  
+             *  ;   submit()    .
+             */
+            struct ResumeActions
+            {
+                using Target = ScheduleAwaiter*;
+
+                static void release(ScheduleAwaiter* owner)
+                {
+                    std::coroutine_handle<> handle = owner->handle;
+                    if (owner->state.exchange(State::Taken, std::memory_order_acq_rel) == State::Suspended)
+                        handle.resume();
+                }
+
+                static void drop(ScheduleAwaiter* owner) { release(owner); }
+            };
+
+            using Ticket = TaskTicket<ResumeActions>;
+
+            Pool& pool;   // Pool to resume on /   
+            int priority; // Priority of the resuming task /   
+            std::coroutine_handle<> handle;                  // Suspended coroutine /  
+            std::atomic<State> state{ State::Submitting };   // Who resumes the coroutine /   
         };
     }
+#endif
+
+    /**
+     * @brief Type of thread pool queue
+     * @brief    
+     */
+    enum class TypePool
+    {
+        Normal,   // Normal FIFO queue /   FIFO
+        Priority,     // Priority-based queue /    
+        WorkStealing, // Per-worker deques with stealing /      
+        LockFree,     // Bounded lock-free ring buffer /    
+        BandedPriority // Lock-free FIFO per priority band /   FIFO    
+    };
+
+    /**
+     * @brief What a push does when the queue is full
+     * @brief  push   
+     *
+     * Tasks pushed by the pool's own workers never wait and never fail: with
+     * Block and Reject the worker runs the task itself, so the pool cannot
+     * deadlock on its own queue and continuations are not lost.
+     *
+     * ,    ,     
+     * :  Block  Reject    ,  
+     *          .
+     */
+    enum class OverflowPolicy
+    {
+        Block,      // Wait for space up to PoolConfig::pushTimeout, then throw QueueFullError /    PoolConfig::pushTimeout,   QueueFullError
+        Reject,     // Throw QueueFullError at once /   QueueFullError
+        CallerRuns, // Run the task on the calling thread /     
+        DropOldest  // Destroy the queued task the queue gives up first, its future reports broken_promise /  ,    ,  future  broken_promise
+    };
+
+    /**
+     * @brief Thrown by push() and submit() when a full queue does not accept the task
+     * @brief  push()  submit(),      
+     */
+    class QueueFullError : public std::runtime_error
+    {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    namespace component
+    {
+        constexpr size_t defaultQueueCapacity = 65536; // Default ring capacity /     
+
+        unsigned int defaultThreadCount();
+        std::vector<std::vector<int>> detectNumaNodes();
+    }
+
+    /**
+     * @brief Named lane of tasks sharing the workers of the pool
+     * @brief   ,    
+     *
+     * Every lane has its own queue. Idle workers take the next task from the
+     * lane with the smallest stride pass, so under load lanes get workers in
+     * proportion to their weights, and a lane without work leaves its share
+     * to the others. reserved workers are kept for the lane: the other lanes
+     * together never run on more than size() - reserved workers (at least
+     * one), so a busy background lane cannot delay the lane it reserves for.
+     *
+     *     .    
+     *       ,   
+     *     ,    
+     *    . reserved    :
+     *        size() - reserved
+     *  (   ),     
+     *  ,    .
+     */
+    struct LaneConfig
+    {
+        std::string name;           // Name for BasicThreadPool::lane() /   BasicThreadPool::lane()
+        unsigned int weight = 1;    // Share of the workers under load /    
+        unsigned int reserved = 0;  // Workers kept free of the other lanes / ,    
+    };
+
+    /**
+     * @brief Construction options of the pool
+     * @brief   
+     *
+     * When nodes is set, worker i belongs to node i % nodes.size() and is
+     * pinned to the cores of that node in turn. Every node gets its own
+     * queue, and workers take tasks from other nodes only after their own
+     * node has run dry. Otherwise, when cpus is set, worker i is pinned to
+     * cpus[i % cpus.size()]. Pinning is best effort and is silently skipped
+     * where the platform does not support it.
+     *
+     *   nodes,   i   i % nodes.size() 
+     *       .   
+     *  ,         ,
+     *     . ,   cpus,  i
+     *    cpus[i % cpus.size()].  
+     *    ,     .
+     *
+     * Setting maxThreads above zero enables the elastic mode. The pool
+     * starts with countThreads clamped to [minThreads, maxThreads]. When a
+     * task is pushed while no worker is idle and the queue already holds
+     * work, one worker is added, up to maxThreads. A worker that has found
+     * nothing to do for keepAlive retires one worker, down to minThreads.
+     * Retired workers are parked as with resize() and reused on growth.
+     *
+     *  maxThreads     . 
+     *   countThreads,  [minThreads, maxThreads]. 
+     *  ,         
+     * ,   ,    maxThreads. , 
+     *    keepAlive,     ,  
+     *  minThreads.      resize() 
+     *    .
+     *
+     * Setting maxQueueSize above zero bounds the Normal and Priority queues
+     * of every node and preallocates their storage. LockFree and
+     * BandedPriority are always bounded by queueCapacity. A push to a full
+     * queue follows overflow.
+     *
+     *  maxQueueSize     Normal 
+     * Priority       . LockFree 
+     * BandedPriority   queueCapacity.  
+     *     overflow.
+     *
+     * Setting lanes splits the pool into lanes, see LaneConfig. The first
+     * lane takes push() and submit() and uses the node queues; the other
+     * lanes are reached with pushToLane() and submitToLane(). With lanes the
+     * workers take tasks one at a time, without LIFO slots or batches.
+     *
+     *  lanes    , . LaneConfig.  
+     *  push()  submit()    ; 
+     *    pushToLane()  submitToLane().  
+     *     ,  LIFO-  .
+     */
+    struct PoolConfig
+    {
+        unsigned int countThreads = component::defaultThreadCount(); // Number of worker threads /   
+        TypePool typePool = TypePool::Normal;               // Type of queue to use /   
+        size_t queueCapacity = component::defaultQueueCapacity; // Ring capacity per node (per band for BandedPriority) /      (   BandedPriority)
+        std::vector<int> cpus;                              // Cores to pin workers to /    
+        std::vector<std::vector<int>> nodes;                // Cores of every NUMA node /    NUMA
+        unsigned int minThreads = 0;                        // Elastic lower bound /    
+        unsigned int maxThreads = 0;                        // Elastic upper bound, 0 disables the mode /    , 0  
+        std::chrono::milliseconds keepAlive{ 60000 };       // Idle time before a worker is retired /       
+        size_t maxQueueSize = 0;                            // Capacity of Normal and Priority queues per node, 0 for unbounded /   Normal  Priority  , 0  
+        OverflowPolicy overflow = OverflowPolicy::Block;    // What a push to a full queue does /     
+        std::chrono::milliseconds pushTimeout{ 0 };         // Longest Block wait, 0 waits until space frees up /   Block, 0   
+        std::vector<LaneConfig> lanes;                      // Lanes of tasks, empty for a single one /  ,   
+    };
 
     /**
      * @brief Thread Pool class for managing and executing tasks concurrently
@@ -35,21 +542,58 @@ namespace tp
      * This class provides a flexible thread pool that can dynamically resize
      * and execute tasks asynchronously with future support.
      *
+     * The queue type is a template parameter. With a concrete queue such as
+     * component::NormalQueue<Task> every push and pop is a direct call that
+     * the compiler can inline. tp::ThreadPool uses the abstract
+     * component::QueueMutex<Task> and picks the queue from TypePool at run
+     * time. For a concrete queue TypePool only matters for WorkStealing,
+     * which adds per-worker deques in front of the queue.
+     *
      *      ,   
      *         future.
+     *
+     *   -  .   , 
+     * component::NormalQueue<Task>,  push  pop -  , 
+     *   . tp::ThreadPool  
+     * component::QueueMutex<Task>     TypePool  
+     * .    TypePool   
+     * WorkStealing,       .
+     *
+     * @tparam QueuePolicy Queue class derived from component::QueueMutex<Task> /  ,   component::QueueMutex<Task>
      */
-    class ThreadPool
+    template <typename QueuePolicy>
+    class BasicThreadPool : public component::CacheAligned
     {
+        static_assert(std::is_base_of<component::QueueMutex<Task>, QueuePolicy>::value,
+            "QueuePolicy must implement component::QueueMutex<Task>");
+
     public:
+        using TypePool = tp::TypePool;
+        using PoolConfig = tp::PoolConfig;
+        using Queue = QueuePolicy;
+
+        static constexpr size_t defaultQueueCapacity = component::defaultQueueCapacity; // Default ring capacity /     
+
         /**
-         * @brief Type of thread pool queue
-         * @brief    
+         * @brief Default number of worker threads
+         * @brief     
+         *
+         * @return std::thread::hardware_concurrency(), at least 1 / std::thread::hardware_concurrency(),   1
          */
-        enum class TypePool
-        {
-            Normal,   // Normal FIFO queue /   FIFO
-            Priority  // Priority-based queue /    
-        };
+        static unsigned int defaultThreadCount() { return component::defaultThreadCount(); }
+
+        /**
+         * @brief Detect NUMA nodes of the machine
+         * @brief   NUMA 
+         *
+         * @return Cores of every node, empty if the platform gives no information /   ,      
+         *
+         * @example
+         * tp::ThreadPool::PoolConfig config;
+         * config.nodes = tp::ThreadPool::detectNumaNodes();
+         * tp::ThreadPool pool(config);
+         */
+        static std::vector<std::vector<int>> detectNumaNodes() { return component::detectNumaNodes(); }
 
         // CONSTRUCTORS & DESTRUCTOR
         //   
@@ -60,7 +604,7 @@ namespace tp
          *
          * @param typePool Type of queue to use /   
          */
-        ThreadPool(TypePool typePool = TypePool::Normal);
+        BasicThreadPool(TypePool typePool = TypePool::Normal);
         
         /**
          * @brief Constructor with specified number of threads
@@ -68,33 +612,47 @@ namespace tp
          *
          * @param numThreads Number of worker threads /   
          * @param typePool Type of queue to use /   
+         * @param queueCapacity Ring capacity for TypePool::LockFree and each band of BandedPriority /     TypePool::LockFree    BandedPriority
+         *
+         * @note Large pools start their workers as a tree, each new worker starts two more
+         * @note     ,      
+         */
+        BasicThreadPool(unsigned int countThreads, TypePool typePool = TypePool::Normal, size_t queueCapacity = defaultQueueCapacity);
+
+        /**
+         * @brief Constructor with full configuration
+         * @brief    
+         *
+         * @param config Pool configuration /  
          */
-        ThreadPool(unsigned int countThreads, TypePool typePool = TypePool::Normal);
+        explicit BasicThreadPool(const PoolConfig& config);
         
         /**
          * @brief Destructor - automatically stops the pool
          * @brief  -   
          */
-        ~ThreadPool();
+        ~BasicThreadPool();
 
         // POOL MANAGEMENT
-//  
-
-/**
- * @brief Resize the thread pool to the specified number of threads
- * @brief        
- *
- * @param countThreads New number of threads in the pool /     
- *
- * @note If increasing size, new threads will be created immediately
- * @note        
- *
- * @note If decreasing size, excess threads will be stopped after completing current tasks
- * @note           
- *
- * @warning Does nothing if pool is stopped or stopping
- * @warning   ,     
- */
+        //  
+
+        /**
+         * @brief Resize the thread pool to the specified number of threads
+         * @brief        
+         *
+         * @param countThreads New number of threads in the pool /     
+         *
+         * @note If increasing size, parked workers are woken first and new threads are created only for the rest
+         * @note       ,      
+         *
+         * @note If decreasing size, excess workers finish their current task and park until a later grow.
+         *       The call returns once they are parked, except on a worker of the pool, which does not wait
+         * @note             .
+         *        ,   ,      ,   
+         *
+         * @warning Does nothing if pool is stopped or stopping
+         * @warning   ,     
+         */
         void resize(unsigned int countThreads);
 
         /**
@@ -124,21 +682,58 @@ namespace tp
          * @note After stopping, the pool cannot be restarted
          * @note     
          *
+         * @note Idle workers and workers parked by resize() leave at once, a worker
+         *       finishes its running task first. Workers join each other on exit
+         * @note    ,  resize(),  , 
+         *          .      
+         *
          * @warning With isWait=false, queued tasks will be discarded without execution
          * @warning  isWait=false       
          */
         void stop(bool isWait = false);
 
+        /**
+         * @brief Wait until every pushed task has finished, keeping the pool running
+         * @brief        
+         *
+         * The pool counts tasks from the push until they have run or have been
+         * dropped, so queued, stolen, batched and running tasks all count. A task
+         * pushed by a running task is counted before its parent finishes, so a
+         * tree of tasks is waited for as a whole. Timers count once they fire.
+         *
+         *         , 
+         *    , ,   
+         * . ,   ,  
+         *  ,     . 
+         *   .
+         *
+         * @param timeout Longest wait, 0 for no limit /   , 0  
+         * @return true if the pool became idle / true    
+         * @return false on timeout, if the pool stops with tasks left, or on a worker of the pool
+         * @return false  ,      ,     
+         *
+         * @note A worker cannot wait, its own task is in flight
+         * @note     ,    
+         *
+         * @example
+         * for (auto& phase : phases) {
+         *     for (auto& item : phase)
+         *         pool.submit(process, item);
+         *     pool.waitIdle(); // Barrier between phases /   
+         * }
+         */
+        bool waitIdle(std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
         /**
          * @brief Get the current number of threads in the pool
          * @brief      
          *
          * @return int Number of worker threads /   
          *
-         * @note This includes both active and idle threads
-         * @note   ,    
+         * @note This includes both active and idle threads, but not workers parked by resize()
+         * @note   ,    ,   ,  resize()
          */
-        int size() { return threads.size(); };
+        int size() { return static_cast<int>(numActive.load(std::memory_order_relaxed)); };
 
         // TASK OPERATIONS
         //   
@@ -153,6 +748,9 @@ namespace tp
          * @note The task is removed from the queue
          * @note    
          *
+         * @note A popped task no longer counts for waitIdle()
+         * @note      waitIdle()
+         *
          * @warning This operation is thread-safe but should be used with caution
          * @warning   ,     
          *
@@ -167,6 +765,97 @@ namespace tp
          */
         std::function<void(int)> pop();
 
+        /**
+         * @brief Execute one pending task on the calling thread
+         * @brief       
+         *
+         * @return true if a task was executed, false if there was nothing to run
+         * @return true    , false   
+         *
+         * @note The task receives the worker ID, or -1 on a thread outside the pool
+         * @note   ID    -1    
+         */
+        bool runPendingTask();
+
+        /**
+         * @brief Check if the calling thread is a worker of this pool
+         * @brief ,        
+         */
+        bool isWorkerThread() const;
+
+        /**
+         * @brief Wait for a future, running queued tasks meanwhile on a worker
+         * @brief  future        
+         *
+         * On a worker of this pool the calling thread keeps taking tasks from
+         * its own deque and the queues until the result is ready, so tasks
+         * that wait for their children cannot starve the pool. On any other
+         * thread this is a plain future.get().
+         *
+         *          
+         *     ,     , 
+         * ,    ,    . 
+         *      future.get().
+         *
+         * @param future Future to wait for /  future
+         * @return Result of the future /  future
+         * @throw The exception stored in the future / ,   future
+         *
+         * @example
+         * auto left = pool.push([](int) { return 1; });
+         * int x = pool.waitFor(std::move(left)); // Inside a task /  
+         */
+        template<typename R>
+        R waitFor(std::future<R> future)
+        {
+            helpUntil([&future]() { return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; },
+                [&future]() { future.wait_for(std::chrono::microseconds(100)); });
+            return future.get();
+        }
+
+        /**
+         * @brief Wait for a shared future, running queued tasks meanwhile on a worker
+         * @brief  shared_future        
+         *
+         * @param future Future to wait for /  future
+         * @return Result of the future /  future
+         * @throw The exception stored in the future / ,   future
+         */
+        template<typename R>
+        decltype(auto) waitFor(const std::shared_future<R>& future)
+        {
+            helpUntil([&future]() { return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; },
+                [&future]() { future.wait_for(std::chrono::microseconds(100)); });
+            return future.get();
+        }
+
+        /**
+         * @brief Run queued tasks on a worker of this pool until isReady() returns true
+         * @brief        ,  isReady()   true
+         *
+         * When there is nothing to run, park() is called to wait briefly for
+         * the condition. On a thread outside the pool nothing is run and the
+         * function returns immediately, leaving the blocking wait to the caller.
+         *
+         *   ,  park()   
+         * .          
+         * ,    .
+         *
+         * @param isReady Condition to wait for /  
+         * @param park Short blocking wait /   
+         */
+        template<typename Ready, typename Park>
+        void helpUntil(Ready isReady, Park park)
+        {
+            if (!isWorkerThread())
+                return;
+
+            while (!isReady()) {
+                if (!runPendingTask())
+                    park();
+            }
+        }
+
         /**
          * @brief Push a task with arguments to the queue
          * @brief      
@@ -206,40 +895,494 @@ namespace tp
         template<typename F, typename... Rest>
         auto push(int priority, F&& f, Rest&&... rest) -> std::future<decltype(f(0, rest...))>
         {
-            auto pck = std::make_shared<std::packaged_task<decltype(f(0, rest...))(int)>>(
-                std::bind(std::forward<F>(f), std::placeholders::_1, std::forward<Rest>(rest)...)
-            );
+            return pushTask(priority, -1, false, std::forward<F>(f), std::forward<Rest>(rest)...);
+        };
 
-            auto fun = new std::function<void(int id)>([pck](int id) {
-                (*pck)(id);
-                });
+        /**
+         * @brief Push a task to the queue of a preferred NUMA node
+         * @brief       NUMA
+         *
+         * @tparam F Function type /  
+         * @tparam Rest Argument types /  
+         * @param node Index of the node in PoolConfig::nodes /    PoolConfig::nodes
+         * @return std::future for getting the result / std::future   
+         */
+        template<typename F, typename... Rest>
+        auto pushToNode(int node, F&& f, Rest&&... rest) -> std::future<decltype(f(0, rest...))>
+        {
+            return pushTask(0, node, false, std::forward<F>(f), std::forward<Rest>(rest)...);
+        };
 
-            // Use priority queue if available, otherwise normal push
-            //      ,   
-            if (typePool == TypePool::Priority) {
-                auto* priorityQueue = dynamic_cast<component::PriorityQueue<std::function<void(int id)>*>*>(queue.get());
-                if (priorityQueue) {
-                    priorityQueue->push(fun, priority);
-                }
-                else {
-                    queue->push(fun);
-                }
-            }
-            else {
-                queue->push(fun);
+        /**
+         * @brief Submit a fire-and-forget task with arguments
+         * @brief       
+         *
+         * Unlike push(), no promise or future is created. Exceptions thrown
+         * by the task are passed to the exception handler of the pool.
+         *
+         *    push(),   promise  future. ,
+         *  ,    .
+         *
+         * @tparam F Function type /  
+         * @tparam Rest Argument types /  
+         */
+        template<typename F, typename... Rest>
+        auto submit(F&& f, Rest&&... rest) -> decltype(void(f(0, rest...)))
+        {
+            this->submit(0, std::forward<F>(f), std::forward<Rest>(rest)...);
+        };
+
+        /**
+         * @brief Submit a fire-and-forget task with priority and arguments
+         * @brief         
+         *
+         * @tparam F Function type /  
+         * @tparam Rest Argument types /  
+         * @param priority Task priority (higher = more important) /   ( = )
+         */
+        template<typename F, typename... Rest>
+        auto submit(int priority, F&& f, Rest&&... rest) -> decltype(void(f(0, rest...)))
+        {
+            schedule(makeTask(std::forward<F>(f), std::forward<Rest>(rest)...), priority);
+        };
+
+        /**
+         * @brief Submit a fire-and-forget task to the queue of a preferred NUMA node
+         * @brief         NUMA
+         *
+         * @tparam F Function type /  
+         * @tparam Rest Argument types /  
+         * @param node Index of the node in PoolConfig::nodes /    PoolConfig::nodes
+         */
+        template<typename F, typename... Rest>
+        auto submitToNode(int node, F&& f, Rest&&... rest) -> decltype(void(f(0, rest...)))
+        {
+            schedule(makeTask(std::forward<F>(f), std::forward<Rest>(rest)...), 0, node);
+        };
+
+        /**
+         * @brief Index of the lane with the given name
+         * @brief     
+         *
+         * @param name Name from PoolConfig::lanes /   PoolConfig::lanes
+         * @throw std::out_of_range if there is no such lane /    
+         */
+        size_t lane(const std::string& name) const;
+
+        /**
+         * @brief Push a task to a lane
+         * @brief    
+         *
+         * Lane 0 is the lane of push(), so every pool accepts it.
+         *  0 -   push(),     .
+         *
+         * @tparam F Function type /  
+         * @tparam Rest Argument types /  
+         * @param lane Index of the lane in PoolConfig::lanes /    PoolConfig::lanes
+         * @return std::future for getting the result / std::future   
+         * @throw std::out_of_range if there is no such lane /    
+         */
+        template<typename F, typename... Rest>
+        auto pushToLane(size_t lane, F&& f, Rest&&... rest) -> std::future<decltype(f(0, rest...))>
+        {
+            auto promise = component::makePromise<decltype(f(0, rest...))>();
+            auto future = promise.get_future();
+            auto bound = std::bind(std::forward<F>(f), std::placeholders::_1, std::forward<Rest>(rest)...);
+
+            scheduleLane(Task([promise = std::move(promise), bound = std::move(bound)](int id) mutable {
+                component::fulfill(promise, bound, id);
+                }), lane);
+            return future;
+        };
+
+        /**
+         * @brief Submit a fire-and-forget task to a lane
+         * @brief      
+         *
+         * @tparam F Function type /  
+         * @tparam Rest Argument types /  
+         * @param lane Index of the lane in PoolConfig::lanes /    PoolConfig::lanes
+         * @throw std::out_of_range if there is no such lane /    
+         */
+        template<typename F, typename... Rest>
+        auto submitToLane(size_t lane, F&& f, Rest&&... rest) -> decltype(void(f(0, rest...)))
+        {
+            scheduleLane(makeTask(std::forward<F>(f), std::forward<Rest>(rest)...), lane);
+        };
+
+        /**
+         * @brief Push a task that is dropped unrun once the token is cancelled
+         * @brief  ,       
+         *
+         * The token is checked when a worker takes the task. A dropped task
+         * leaves its future with broken_promise.
+         *
+         *  ,     . 
+         *    future  broken_promise.
+         *
+         * @tparam F Function type /  
+         * @tparam Rest Argument types /  
+         * @param token Token shared with the caller or a group / ,     
+         * @return std::future for getting the result / std::future   
+         */
+        template<typename F, typename... Rest>
+        auto push(const CancellationToken& token, F&& f, Rest&&... rest) -> std::future<decltype(f(0, rest...))>
+        {
+            auto promise = component::makePromise<decltype(f(0, rest...))>();
+            auto future = promise.get_future();
+            auto bound = std::bind(std::forward<F>(f), std::placeholders::_1, std::forward<Rest>(rest)...);
+
+            // A skipped promise is destroyed with the task
+            //  promise    
+            schedule(Task([token, promise = std::move(promise), bound = std::move(bound)](int id) mutable {
+                if (!token.isCancelled())
+                    component::fulfill(promise, bound, id);
+                }), 0);
+            return future;
+        };
+
+        /**
+         * @brief Submit a fire-and-forget task that is dropped unrun once the token is cancelled
+         * @brief    ,       
+         *
+         * @tparam F Function type /  
+         * @tparam Rest Argument types /  
+         * @param token Token shared with the caller or a group / ,     
+         */
+        template<typename F, typename... Rest>
+        auto submit(const CancellationToken& token, F&& f, Rest&&... rest) -> decltype(void(f(0, rest...)))
+        {
+            schedule(makeCancellableTask(token, std::forward<F>(f), std::forward<Rest>(rest)...), 0);
+        };
+
+        /**
+         * @brief Token of a group of tasks, such as the subtasks of one request
+         * @brief   ,    
+         *
+         * Every call with the same id returns the same token until
+         * cancelGroup(id). The pool remembers the group only while some copy
+         * of its token is alive.
+         *
+         *     id       
+         * cancelGroup(id).   ,    -
+         *   .
+         *
+         * @param group Group id chosen by the caller /  ,  
+         * @return Token to push the tasks of the group with /     
+         *
+         * @example
+         * pool.submit(pool.groupToken(requestId), parsePart, part);
+         * ...
+         * pool.cancelGroup(requestId); // Pending parts are skipped /   
+         */
+        CancellationToken groupToken(std::uint64_t group);
+
+        /**
+         * @brief Cancel every pending task of a group
+         * @brief     
+         *
+         * The tasks stay in the queue until a worker reaches them and drops
+         * them unrun. A later groupToken(id) starts a new group.
+         *
+         *    ,        
+         *     .  groupToken(id) 
+         *  .
+         *
+         * @param group Group id /  
+         * @return true if the group existed / true   
+         */
+        bool cancelGroup(std::uint64_t group);
+
+        /**
+         * @brief Push a task only if the queue has room
+         * @brief  ,      
+         *
+         * Never waits and ignores PoolConfig::overflow.
+         *       PoolConfig::overflow.
+         *
+         * @tparam F Function type /  
+         * @tparam Rest Argument types /  
+         * @return std::future for the result, not valid() if the queue is full / std::future  ,  valid()   
+         *
+         * @example
+         * auto future = pool.tryPush(handleRequest, request);
+         * if (!future.valid())
+         *     reply(request, "503 Busy");
+         */
+        template<typename F, typename... Rest>
+        auto tryPush(F&& f, Rest&&... rest) -> std::future<decltype(f(0, rest...))>
+        {
+            return this->tryPush(0, std::forward<F>(f), std::forward<Rest>(rest)...);
+        };
+
+        /**
+         * @brief Push a task with priority only if the queue has room
+         * @brief    ,      
+         *
+         * @tparam F Function type /  
+         * @tparam Rest Argument types /  
+         * @param priority Task priority (higher = more important) /   ( = )
+         * @return std::future for the result, not valid() if the queue is full / std::future  ,  valid()   
+         */
+        template<typename F, typename... Rest>
+        auto tryPush(int priority, F&& f, Rest&&... rest) -> std::future<decltype(f(0, rest...))>
+        {
+            return pushTask(priority, -1, true, std::forward<F>(f), std::forward<Rest>(rest)...);
+        };
+
+        /**
+         * @brief Submit a fire-and-forget task only if the queue has room
+         * @brief    ,      
+         *
+         * @tparam F Function type /  
+         * @tparam Rest Argument types /  
+         * @return true if the task was queued / true     
+         */
+        template<typename F, typename... Rest>
+        auto trySubmit(F&& f, Rest&&... rest) -> decltype(void(f(0, rest...)), bool())
+        {
+            return this->trySubmit(0, std::forward<F>(f), std::forward<Rest>(rest)...);
+        };
+
+        /**
+         * @brief Submit a fire-and-forget task with priority only if the queue has room
+         * @brief      ,      
+         *
+         * @tparam F Function type /  
+         * @tparam Rest Argument types /  
+         * @param priority Task priority (higher = more important) /   ( = )
+         * @return true if the task was queued / true     
+         */
+        template<typename F, typename... Rest>
+        auto trySubmit(int priority, F&& f, Rest&&... rest) -> decltype(void(f(0, rest...)), bool())
+        {
+            return schedule(makeTask(std::forward<F>(f), std::forward<Rest>(rest)...), priority, -1, true);
+        };
+
+        /**
+         * @brief Push a task, or run it on the caller when the pool is saturated
+         * @brief           
+         *
+         * When no worker is idle and more tasks are queued than the inline
+         * threshold, queuing a small task only adds queue traffic, so it runs
+         * right here and the returned future is already ready. Nested inline
+         * runs on one thread are limited, deeper calls are queued as by push().
+         * An inline task gets the ID of the calling worker, -1 elsewhere.
+         *
+         *         ,  
+         *  ,      
+         *    ,     , 
+         *  future  .    
+         *   ,        push().
+         *    ID   ,  -1.
+         *
+         * @tparam F Function type /  
+         * @tparam Rest Argument types /  
+         * @return std::future for getting the result / std::future   
+         * @see setInlineThreshold()
+         */
+        template<typename F, typename... Rest>
+        auto pushOrRun(F&& f, Rest&&... rest) -> std::future<decltype(f(0, rest...))>
+        {
+            if (!isInlineRun())
+                return pushTask(0, -1, false, std::forward<F>(f), std::forward<Rest>(rest)...);
+
+            auto promise = component::makePromise<decltype(f(0, rest...))>();
+            auto future = promise.get_future();
+            auto bound = std::bind(std::forward<F>(f), std::placeholders::_1, std::forward<Rest>(rest)...);
+
+            runInline(Task([promise = std::move(promise), bound = std::move(bound)](int id) mutable {
+                component::fulfill(promise, bound, id);
+                }));
+            return future;
+        };
+
+        /**
+         * @brief Submit a fire-and-forget task that is queued after a delay
+         * @brief    ,      
+         *
+         * Timers are kept in a timer wheel with millisecond resolution and
+         * are serviced by the workers themselves: one idle worker sleeps until
+         * the next deadline, and busy workers check it between tasks. No
+         * thread is blocked per timer. A due task is queued like submit() and
+         * may start later if all workers are busy. Timers that have not fired
+         * by stop() are discarded.
+         *
+         *          
+         *    :     
+         *  ,       .
+         *        .  
+         *     submit()    ,  
+         *  . ,    stop(), .
+         *
+         * @tparam F Function type /  
+         * @param delay Time before the task is queued /      
+         * @return Handle for cancelling the timer /    
+         *
+         * @example
+         * tp::TimerHandle timeout = pool.pushAfter(std::chrono::seconds(5), [](int) { std::cout << "Timeout\n"; });
+         * timeout.cancel(); // The reply came in time /   
+         */
+        template<typename Rep, typename Period, typename F>
+        TimerHandle pushAfter(const std::chrono::duration<Rep, Period>& delay, F&& f)
+        {
+            std::unique_ptr<component::TimerEntry> entry(new component::TimerEntry());
+            entry->deadline = component::TimerWheel::deadlineAfter(delay);
+            entry->task = makeTask(std::forward<F>(f));
+            return addTimer(std::move(entry));
+        }
+
+        /**
+         * @brief Submit a fire-and-forget task that is queued at a point in time
+         * @brief    ,       
+         *
+         * Time points of other clocks are converted to the steady clock when the timer is added.
+         *          .
+         *
+         * @tparam F Function type /  
+         * @param time Time to queue the task at /     
+         * @return Handle for cancelling the timer /    
+         */
+        template<typename Clock, typename Duration, typename F>
+        TimerHandle pushAt(const std::chrono::time_point<Clock, Duration>& time, F&& f)
+        {
+            return this->pushAfter(time - Clock::now(), std::forward<F>(f));
+        }
+
+        /**
+         * @brief Submit a fire-and-forget task that is queued every period
+         * @brief    ,      
+         *
+         * The first run is queued one period from now. Deadlines follow a
+         * fixed schedule, runs missed while the pool was busy are skipped
+         * rather than queued in a burst. A run that lasts longer than the
+         * period may overlap with the next one.
+         *
+         *        .  
+         *  , ,     ,
+         * ,      . , 
+         *  ,    .
+         *
+         * @tparam F Copyable function type /   
+         * @param period Time between runs, at least one millisecond /   ,   
+         * @return Handle for stopping the timer /    
+         */
+        template<typename Rep, typename Period, typename F>
+        TimerHandle pushEvery(const std::chrono::duration<Rep, Period>& period, F&& f)
+        {
+            std::unique_ptr<component::TimerEntry> entry(new component::TimerEntry());
+            entry->period = std::max<std::int64_t>(1, component::TimerWheel::ticks(period));
+            entry->deadline = component::TimerWheel::deadlineAfter(period);
+            entry->body = std::make_shared<std::function<void(int)>>(std::forward<F>(f));
+            return addTimer(std::move(entry));
+        }
+
+#ifdef TP_HAS_COROUTINES
+        /**
+         * @brief Move the awaiting coroutine onto a worker thread
+         * @brief      
+         *
+         * The resuming task is submitted like any other, no future is created.
+         * Coroutines still queued when the pool is stopped with isWait=false
+         * are never resumed.
+         *
+         *      , future 
+         * . ,       
+         * isWait=false,   .
+         *
+         * @param priority Priority of the resuming task /   
+         * @return Awaitable object /  
+         *
+         * @example
+         * tp::task<int> work(tp::ThreadPool& pool) {
+         *     co_await pool.schedule();
+         *     co_return 42; // Runs on a worker /    
+         * }
+         */
+        component::ScheduleAwaiter<BasicThreadPool> schedule(int priority = 0)
+        {
+            return component::ScheduleAwaiter<BasicThreadPool>(*this, priority);
+        }
+#endif
+
+        /**
+         * @brief Push a range of tasks with a single queue operation and wake-up
+         * @brief          
+         *
+         * Every element of the range must be callable with the thread ID. Elements
+         * are copied, use std::make_move_iterator to move them instead.
+         *
+         *       ID . 
+         * ,    std::make_move_iterator.
+         *
+         * @tparam InputIt Iterator type /  
+         * @param first Beginning of the range /  
+         * @param last End of the range /  
+         * @return Futures in the order of the range / Future   
+         */
+        template<typename InputIt>
+        auto pushBatch(InputIt first, InputIt last) -> std::vector<std::future<decltype((*first)(0))>>
+        {
+            using R = decltype((*first)(0));
+            std::vector<std::future<R>> futures;
+            std::vector<Task> tasks;
+
+            for (; first != last; ++first) {
+                auto promise = component::makePromise<R>();
+                futures.push_back(promise.get_future());
+                tasks.emplace_back([promise = std::move(promise), fn = *first](int id) mutable {
+                    component::fulfill(promise, fn, id);
+                    });
             }
 
-            std::unique_lock<std::mutex> lock(this->mutex);
-            this->cv.notify_one();
-            return pck->get_future();
+            scheduleBatch(tasks);
+            return futures;
+        };
+
+        /**
+         * @brief Submit a range of fire-and-forget tasks with a single queue operation and wake-up
+         * @brief            
+         *
+         * @tparam InputIt Iterator type /  
+         * @param first Beginning of the range /  
+         * @param last End of the range /  
+         */
+        template<typename InputIt>
+        auto submitBatch(InputIt first, InputIt last) -> decltype(void((*first)(0)))
+        {
+            std::vector<Task> tasks;
+            for (; first != last; ++first)
+                tasks.emplace_back(*first);
+
+            scheduleBatch(tasks);
         };
 
+        /**
+         * @brief Handler for exceptions escaping tasks
+         * @brief  ,   
+         *
+         * Receives the worker ID and the caught exception. Must not throw.
+         *  ID     .    .
+         */
+        using ExceptionHandler = std::function<void(int id, std::exception_ptr exception)>;
+
+        /**
+         * @brief Set the handler for exceptions escaping tasks
+         * @brief   ,   
+         *
+         * @param handler New handler, empty to restore printing to std::cerr /  ,      std::cerr
+         *
+         * @note Tasks added with push() report exceptions through their future
+         * @note ,   push(),     future
+         */
+        void setExceptionHandler(ExceptionHandler handler);
+
         // DELETED COPY AND MOVE SEMANTICS
         //     
-        ThreadPool(const ThreadPool&) = delete;
-        ThreadPool(ThreadPool&&) = delete;
-        ThreadPool& operator=(const ThreadPool&) = delete;
-        ThreadPool& operator=(ThreadPool&&) = delete;
+        BasicThreadPool(const BasicThreadPool&) = delete;
+        BasicThreadPool(BasicThreadPool&&) = delete;
+        BasicThreadPool& operator=(const BasicThreadPool&) = delete;
+        BasicThreadPool& operator=(BasicThreadPool&&) = delete;
 
         /**
          * @brief Get the number of idle threads in the pool
@@ -248,7 +1391,117 @@ namespace tp
          * @return int Number of threads currently waiting for tasks
          * @return int  ,     
          */
-        int numIdle() { return this->numWaiting; }
+        int numIdle() { return this->numWaiting + this->numSpinning; }
+
+        /**
+         * @brief Take a snapshot of the pool metrics
+         * @brief    
+         *
+         * Reads atomic counters only and never takes the pool mutex, so it is
+         * cheap enough to poll from a monitoring thread. Counters are collected
+         * only when the pool is built with TP_ENABLE_METRICS, otherwise the
+         * snapshot is empty and isEnabled is false.
+         *
+         *         , 
+         *       .  
+         *     TP_ENABLE_METRICS,   , 
+         * isEnabled  false.
+         *
+         * @return PoolStats Counters, queue depth and latency histograms / ,     
+         */
+        PoolStats stats() const;
+
+        /**
+         * @brief Start recording trace events
+         * @brief    
+         *
+         * Workers record before each dequeue, task begin and end, park and
+         * unpark; every push records the task with the label of the pushing
+         * thread (see TraceLabel). Events go to a lock-free ring per worker
+         * plus one shared by other threads. While tracing is off each hook
+         * costs one well-predicted branch. Restarting with the same capacity
+         * reuses the buffers.
+         *
+         *       ,  
+         *   ,    ;  
+         *       (. TraceLabel).
+         *          
+         *    .   , 
+         *      .  
+         *        .
+         *
+         * @param capacity Events kept per ring between flushes /     
+         */
+        void startTrace(size_t capacity = 16384);
+
+        /**
+         * @brief Stop recording, recorded events stay until flushTrace()
+         * @brief  ,     flushTrace()
+         */
+        void stopTrace() { tracing.store(nullptr, std::memory_order_release); }
+
+        /**
+         * @brief Write the events recorded since the last flush as Chrome trace JSON
+         * @brief        JSON Chrome trace
+         *
+         * The output loads in chrome://tracing and ui.perfetto.dev. Can be
+         * called while tracing runs.
+         *
+         *    chrome://tracing  ui.perfetto.dev. 
+         *    .
+         */
+        void flushTrace(std::ostream& out);
+
+        /**
+         * @brief Configure how long an idle worker polls before parking
+         * @brief  ,       
+         *
+         * An idle worker first polls the queue spinCount times with a CPU pause
+         * between polls, then yieldCount times with std::this_thread::yield(),
+         * and only then sleeps on the condition variable. The default (0, 0)
+         * parks immediately, which suits batch jobs. Low-latency services can
+         * spin to avoid the wake-up cost.
+         *
+         *      spinCount   
+         *   ,  yieldCount  
+         * std::this_thread::yield(),       
+         * .    (0, 0)   ,
+         *     .     
+         *   ,     .
+         *
+         * @param spinCount Polls with CPU pause /    
+         * @param yieldCount Polls with thread yield /    
+         */
+        void setIdleSpin(unsigned int spinCount, unsigned int yieldCount = 0)
+        {
+            this->spinCount = spinCount;
+            this->yieldCount = yieldCount;
+        }
+
+        /**
+         * @brief Configure when pushOrRun() runs tasks inline
+         * @brief  ,  pushOrRun()    
+         *
+         * pushOrRun() runs a task on the caller only while no worker is idle
+         * and more than numQueued tasks wait in the queues, and only up to
+         * maxDepth nested inline runs per thread. The queue depth is estimated
+         * from the pushed but unfinished tasks minus the active workers. The
+         * defaults are 64 tasks and a depth of 8.
+         *
+         * pushOrRun()     ,   
+         *        numQueued ,  
+         *  maxDepth     . 
+         *    ,     
+         *  .   64    8.
+         *
+         * @param numQueued Queued tasks above which tasks run inline /   ,      
+         * @param maxDepth Nested inline runs per thread, 0 never runs inline /     , 0  
+         */
+        void setInlineThreshold(size_t numQueued, unsigned int maxDepth = 8)
+        {
+            this->inlineThreshold = numQueued;
+            this->maxInlineDepth = maxDepth;
+        }
 
         /**
          * @brief Get reference to a specific thread by index
@@ -305,22 +1558,182 @@ namespace tp
         // INTERNAL METHODS
         //  
 
-        void init(TypePool typePool);
-        void setThread(int ind);
+        void init(const PoolConfig& config);
+        void addThreads(unsigned int numThreads);
+        void setThread(int ind, component::StartTree* tree = nullptr);
+        void startChildren(int ind, component::StartTree& tree);
+        void exitWorker(int ind);
+        size_t targetNode(int node);
+        bool schedule(Task&& task, int priority, int node = -1, bool isTry = false);
+        void scheduleBatch(std::vector<Task>& tasks);
+        void scheduleLane(Task&& task, size_t lane);
+        void execute(Task& task, int ind);
+        bool spinForTask(Task& task, std::atomic<bool>& flag);
+        bool parkWorker(component::WorkerBlock& block);
+        void wakeOne();
+        void resizeLocked(unsigned int numThreads);
+        void growIfBusy(size_t node);
+        void retireIdle();
+        bool isElastic() const { return config.maxThreads > 0; }
+        TimerHandle addTimer(std::unique_ptr<component::TimerEntry> entry);
+        void fireTimers();
+        void clearTimers();
+        bool hasTimers() const { return nextTimer.load(std::memory_order_relaxed) != component::TimerWheel::never; }
+        bool isTimerDue() const;
+        void handleException(int ind, std::exception_ptr exception);
+        void enqueue(Task&& task, size_t node, int priority = 0);
+        bool admit(Task&& task, size_t node, int priority, bool isTry);
+        bool waitForSpace(Task& task, size_t node, int priority);
+        void notifySpace(size_t count);
+        void finishTasks(std::int64_t count);
+        bool isInlineRun() const;
+        void runInline(Task&& task);
+        void trace(TraceEvent event, const char* label = nullptr);
+        void tracePush(Task* tasks, size_t count);
+        void traceLabel(Task* tasks, size_t count);
+        void traceEvents(TraceEvent event, size_t count);
+        bool popTask(Task& task);
+        bool popDefault(Task& task);
+        bool popLane(Task& task);
+        bool enterLane(size_t lane);
+        bool popQueue(Task& task, size_t node);
+        bool stealTask(Task& task, size_t node);
+        bool stealSlot(Task& task);
+        void releaseLocal();
+        void updateWorkers();
+
+        void countQueued(std::int64_t count)
+        {
+#ifdef TP_ENABLE_METRICS
+            this->queued.fetch_add(count, std::memory_order_relaxed);
+#else
+            (void)count;
+#endif
+        }
+
+        template<typename F, typename... Rest>
+        auto pushTask(int priority, int node, bool isTry, F&& f, Rest&&... rest) -> std::future<decltype(f(0, rest...))>
+        {
+            auto promise = component::makePromise<decltype(f(0, rest...))>();
+            auto future = promise.get_future();
+            auto bound = std::bind(std::forward<F>(f), std::placeholders::_1, std::forward<Rest>(rest)...);
+
+            // The promise and the bound call are moved into the task's inline storage
+            // promise        
+            bool isQueued = schedule(Task([promise = std::move(promise), bound = std::move(bound)](int id) mutable {
+                component::fulfill(promise, bound, id);
+                }), priority, node, isTry);
+            if (!isQueued)
+                return std::future<decltype(f(0, rest...))>();
+            return future;
+        }
+
+        template<typename F, typename... Rest>
+        static Task makeCancellableTask(const CancellationToken& token, F&& f, Rest&&... rest)
+        {
+            auto bound = std::bind(std::forward<F>(f), std::placeholders::_1, std::forward<Rest>(rest)...);
+            return Task([token, bound = std::move(bound)](int id) mutable {
+                if (!token.isCancelled())
+                    bound(id);
+                });
+        }
+
+        template<typename F>
+        static Task makeTask(F&& f)
+        {
+            return Task(std::forward<F>(f));
+        }
+
+        template<typename F, typename Arg, typename... Rest>
+        static Task makeTask(F&& f, Arg&& arg, Rest&&... rest)
+        {
+            return Task(std::bind(std::forward<F>(f), std::placeholders::_1, std::forward<Arg>(arg), std::forward<Rest>(rest)...));
+        }
 
         // MEMBER VARIABLES
         // -
+
+        // Read by every thread and written rarely, these may share lines
+        //      ,    
         TypePool typePool;                                    // Type of queue used /   
+        PoolConfig config;                                    // Construction options /  
         std::vector<component::SingThread> threads;           // Collection of worker threads /   
-        std::unique_ptr<component::QueueMutex<std::function<void(int id)>*>> queue; // Task queue /  
-
+        std::atomic<unsigned int> numActive;                  // Workers not parked, always the first ones /  ,  
+        std::vector<std::unique_ptr<QueuePolicy>> queues;    // Task queue of every node, then of every lane after the first /    ,     
+        size_t numNodes;                                      // Queues that belong to nodes / ,  
+        std::vector<std::unique_ptr<component::Lane>> lanes;  // Lanes, empty without PoolConfig::lanes / ,   PoolConfig::lanes
+        bool hasReserved;                                     // Some lane reserves workers / -   
         std::atomic<bool> isDone;     // Flag indicating completion /   
         std::atomic<bool> isStop;     // Flag indicating immediate stop /   
-        std::atomic<int> numWaiting;  // Number of waiting threads /   
+        std::atomic<unsigned int> spinCount;  // Polls with CPU pause before parking /     
+        std::atomic<unsigned int> yieldCount; // Polls with yield before parking /     
+        std::atomic<size_t> inlineThreshold;  // Queued tasks above which pushOrRun() runs inline /   ,   pushOrRun()   
+        std::atomic<unsigned int> maxInlineDepth; // Nested inline runs per thread /     
+        std::shared_ptr<component::DequeList> deques; // Snapshot of deques for stealing /     
+        std::shared_ptr<component::SlotList> slots;   // Snapshot of LIFO slots /  LIFO-
+        bool isLifoSlot;                              // Worker tasks go to the LIFO slot /      LIFO-
+        bool isBatching;                              // Workers pop tasks in batches /     
+        std::vector<std::unique_ptr<component::TaskBatch>> batches; // Batch of every node when batching /      
+#ifdef TP_ENABLE_METRICS
+        std::shared_ptr<std::vector<std::shared_ptr<component::WorkerMetrics>>> metrics; // Snapshot of worker counters /   
+#endif
+        std::shared_ptr<const ExceptionHandler> exceptionHandler; // Handler for task exceptions /   
+        std::atomic<std::int64_t> nextTimer;          // Earliest tick a timer may be due /     
+        std::atomic<component::TraceSession*> tracing; // Running trace, nullptr when off /  , nullptr  
 
-        std::mutex mutex;             // Mutex for synchronization /   
+        // Counters written on every park, spin or push, each on its own line
+        // ,    ,   ,    
+        alignas(64) std::atomic<int> numWaiting;  // Number of waiting threads /   
+        alignas(64) std::atomic<int> numSpinning; // Number of spinning threads /     
+        alignas(64) std::atomic<unsigned int> nextNode; // Round-robin node for external tasks /      
+        alignas(64) std::atomic<bool> isTimerKeeper;    // An idle worker sleeps until the next timer /      
+        alignas(64) std::atomic<int> numBlocked;        // Producers waiting for queue space / ,    
+        alignas(64) std::atomic<std::int64_t> numInFlight; // Tasks pushed and not finished or dropped yet /         
+        alignas(64) std::atomic<int> numIdleWaiters;     // Threads in waitIdle() /   waitIdle()
+#ifdef TP_ENABLE_METRICS
+        alignas(64) std::atomic<std::int64_t> queued; // Tasks in queues and deques /     
+#endif
+
+        // Taken only to sleep and to wake sleepers
+        //      
+        alignas(64) std::mutex mutex; // Mutex for synchronization /   
         std::condition_variable cv;   // Condition variable for task notification /    
+        std::condition_variable parkCv; // resize() waits here for the workers it parks /  resize()    
+        unsigned int numParked;       // Workers parked by resize(), guarded by mutex / ,  resize(),   mutex
+        alignas(64) std::mutex resizeMutex; // Serializes resize() and stop(), exiting workers read threads under it /  resize()  stop(),    threads  
+        std::mutex timerMutex;              // Guards the timer wheel /   
+        component::TimerWheel timers;       // Delayed and periodic tasks /    
+
+        std::mutex groupMutex;              // Guards groups /  groups
+        std::unordered_map<std::uint64_t, std::weak_ptr<component::CancellationState>> groups; // Tokens of live groups /   
+        size_t groupPruneSize;              // Size at which dead groups are erased / ,     
+
+        std::mutex traceMutex;              // Serializes starting and flushing traces /     
+        std::vector<std::unique_ptr<component::TraceSession>> traceSessions; // Every trace run, kept while hooks may still write /   , ,    
+
+        // Workers notify blocked producers and idle waiters while they may hold mutex
+        //        ,   mutex
+        alignas(64) std::mutex spaceMutex;   // Taken only to block on and to notify spaceCv /       spaceCv
+        std::condition_variable spaceCv;     // Producers blocked on a full queue wait here /   ,   
+        std::mutex idleMutex;                // Taken only to block on and to notify idleCv /       idleCv
+        std::condition_variable idleCv;      // waitIdle() waits here /   waitIdle()
+
+        static thread_local component::WorkerContext currentWorker; // Worker running on this thread /  ,    
     };
+
+    /**
+     * @brief Thread pool with the queue chosen at run time by TypePool
+     * @brief    ,      TypePool
+     */
+    using ThreadPool = BasicThreadPool<component::QueueMutex<Task>>;
+
+    // Pools with these queues are compiled in ThreadPool.cpp
+    //       ThreadPool.cpp
+    extern template class BasicThreadPool<component::QueueMutex<Task>>;
+    extern template class BasicThreadPool<component::NormalQueue<Task>>;
+    extern template class BasicThreadPool<component::PriorityQueue<Task>>;
+    extern template class BasicThreadPool<component::RingQueue<Task>>;
+    extern template class BasicThreadPool<component::BandedPriorityQueue<Task>>;
 }
 
 #endif // THREAD_POOL_H
\ No newline at end of file
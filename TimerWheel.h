@@ -0,0 +1,372 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <limits>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include "Task.h"
+
+namespace tp
+{
+    namespace component
+    {
+        /**
+         * @brief Shared state of one timer, seen by the pool and the handle
+         * @brief    ,    
+         */
+        struct TimerState
+        {
+            enum Status : int { Pending, Fired, Cancelled };
+
+            std::atomic<int> status{ Pending }; // Current status /  
+        };
+
+        /**
+         * @brief Timer stored in the wheel
+         * @brief ,   
+         */
+        struct TimerEntry
+        {
+            std::int64_t deadline = 0;                   // Tick the timer is due /  
+            std::int64_t period = 0;                     // Ticks between runs, 0 for one-shot /   , 0  
+            Task task;                                   // Body of a one-shot timer /   
+            std::shared_ptr<std::function<void(int)>> body; // Body of a periodic timer /   
+            std::shared_ptr<TimerState> state;           // Status shared with the handle / ,   
+            TimerEntry* next = nullptr;                  // Next timer in the same slot /      
+        };
+
+        /**
+         * @brief Hierarchical timer wheel with millisecond ticks
+         * @brief       
+         *
+         * Four levels of 64 slots cover 2^24 ticks (about 4.6 hours), later
+         * timers wait in an overflow list. Adding a timer is O(1): its level
+         * follows from the distance to the deadline. As time advances, the
+         * slots of a higher level are spread over the lower ones once per
+         * turn, so every timer is moved at most once per level. Long stretches
+         * without timers on the low levels are skipped whole.
+         *
+         * Not thread-safe, the pool guards it with its own mutex.
+         *
+         *    64   2^24  ( 4,6 ),
+         *       .  
+         *   O(1):     . 
+         *         
+         *   ,     
+         *     .     
+         *    .
+         *
+         *  ,     .
+         */
+        class TimerWheel
+        {
+        public:
+            static constexpr int numLevels = 4;                 // Wheel levels /  
+            static constexpr int slotBits = 6;                  // log2 of slots per level / log2    
+            static constexpr std::int64_t numSlots = 1 << slotBits; // Slots per level /   
+            static constexpr std::int64_t never = std::numeric_limits<std::int64_t>::max(); // No timer pending /   
+
+            using Clock = std::chrono::steady_clock;
+            using Tick = std::chrono::milliseconds;
+
+            TimerWheel() : current(now()) {}
+            ~TimerWheel() { this->clear(); }
+
+            TimerWheel(const TimerWheel&) = delete;
+            TimerWheel& operator=(const TimerWheel&) = delete;
+
+            /**
+             * @brief Current tick of the steady clock
+             * @brief    
+             */
+            static std::int64_t now() { return tickOf(Clock::now()); }
+
+            /**
+             * @brief Tick of a time point, rounded down
+             * @brief   ,  
+             */
+            static std::int64_t tickOf(Clock::time_point time)
+            {
+                return std::chrono::duration_cast<Tick>(time.time_since_epoch()).count();
+            }
+
+            /**
+             * @brief Time point at which a tick begins
+             * @brief  ,    
+             */
+            static Clock::time_point timeOf(std::int64_t tick) { return Clock::time_point(Tick(tick)); }
+
+            /**
+             * @brief Number of ticks in a duration, rounded up
+             * @brief    ,  
+             */
+            template <typename Rep, typename Period>
+            static std::int64_t ticks(const std::chrono::duration<Rep, Period>& duration)
+            {
+                Tick whole = std::chrono::duration_cast<Tick>(duration);
+                if (whole < duration)
+                    whole += Tick(1);
+                return whole.count();
+            }
+
+            /**
+             * @brief Tick at which a delay that starts now has surely passed
+             * @brief ,   ,  ,  
+             *
+             * The current tick has already begun, so one more tick keeps the delay from being cut short.
+             *    ,        .
+             */
+            template <typename Rep, typename Period>
+            static std::int64_t deadlineAfter(const std::chrono::duration<Rep, Period>& delay)
+            {
+                return now() + ticks(delay) + 1;
+            }
+
+            /**
+             * @brief Number of pending timers
+             * @brief   
+             */
+            size_t size() const { return this->count; }
+
+            /**
+             * @brief Add a timer, a deadline already passed fires on the next tick
+             * @brief  ,      
+             *
+             * @param entry Timer owned by the wheel from now on / ,    
+             */
+            void add(TimerEntry* entry)
+            {
+                // An empty wheel catches up first, so the timer lands on the level of its real distance
+                //     ,        
+                if (this->count == 0)
+                    this->current = std::max(this->current, now());
+                if (entry->deadline <= this->current)
+                    entry->deadline = this->current + 1;
+                this->place(entry);
+                ++this->count;
+            }
+
+            /**
+             * @brief Advance the wheel to tick and take the timers that are due
+             * @brief     tick    
+             *
+             * @param tick Tick to advance to / ,    
+             * @return List of due timers linked by next, owned by the caller /   ,   next,  
+             */
+            TimerEntry* advance(std::int64_t tick)
+            {
+                TimerEntry* due = nullptr;
+                while (this->current < tick) {
+                    if (this->count == 0) {
+                        this->current = tick;
+                        break;
+                    }
+
+                    // Nothing below the lowest non-empty level can fire before its next boundary
+                    //            
+                    int level = 0;
+                    while (level < numLevels && this->levelCount[level] == 0)
+                        ++level;
+                    if (level > 0) {
+                        std::int64_t last = this->current | ((std::int64_t(1) << (slotBits * level)) - 1);
+                        if (last >= tick) {
+                            this->current = tick;
+                            break;
+                        }
+                        this->current = last;
+                    }
+
+                    ++this->current;
+                    this->cascade();
+
+                    TimerEntry*& slot = this->slots[0][this->current & (numSlots - 1)];
+                    while (slot) {
+                        TimerEntry* entry = slot;
+                        slot = entry->next;
+                        entry->next = due;
+                        due = entry;
+                        --this->levelCount[0];
+                        --this->count;
+                    }
+                }
+                return due;
+            }
+
+            /**
+             * @brief Earliest tick at which advance() may return a timer
+             * @brief   ,   advance()   
+             *
+             * Exact for the lowest level, for higher levels this is the tick at
+             * which their next non-empty slot is spread downwards.
+             *
+             *    ,     ,  
+             *      .
+             *
+             * @return Tick, never if the wheel is empty / , never   
+             */
+            std::int64_t next() const
+            {
+                if (this->count == 0)
+                    return never;
+
+                std::int64_t result = never;
+                for (int level = 0; level < numLevels; ++level) {
+                    if (this->levelCount[level] == 0)
+                        continue;
+
+                    int shift = slotBits * level;
+                    std::int64_t block = this->current >> shift;
+                    for (std::int64_t i = 1; i <= numSlots; ++i) {
+                        if (this->slots[level][(block + i) & (numSlots - 1)]) {
+                            result = std::min(result, (block + i) << shift);
+                            break;
+                        }
+                    }
+                }
+
+                if (this->overflow) {
+                    std::int64_t span = std::int64_t(1) << (slotBits * numLevels);
+                    result = std::min(result, ((this->current >> (slotBits * numLevels)) + 1) * span);
+                }
+                return result;
+            }
+
+            /**
+             * @brief Remove all timers and mark them cancelled
+             * @brief       
+             */
+            void clear()
+            {
+                for (int level = 0; level < numLevels; ++level) {
+                    for (std::int64_t i = 0; i < numSlots; ++i)
+                        this->release(this->slots[level][i]);
+                    this->levelCount[level] = 0;
+                }
+                this->release(this->overflow);
+                this->count = 0;
+            }
+
+        private:
+            /**
+             * @brief Put a timer on the level that matches its distance
+             * @brief    ,   
+             */
+            void place(TimerEntry* entry)
+            {
+                std::int64_t delta = entry->deadline - this->current;
+                for (int level = 0; level < numLevels; ++level) {
+                    int shift = slotBits * level;
+                    if (delta < (numSlots << shift)) {
+                        TimerEntry*& slot = this->slots[level][(entry->deadline >> shift) & (numSlots - 1)];
+                        entry->next = slot;
+                        slot = entry;
+                        ++this->levelCount[level];
+                        return;
+                    }
+                }
+                entry->next = this->overflow;
+                this->overflow = entry;
+            }
+
+            /**
+             * @brief Spread the slots that start at the current tick over the lower levels
+             * @brief  ,    ,   
+             */
+            void cascade()
+            {
+                // Higher levels first, so their timers can land in slots spread at this tick
+                //   ,         
+                std::int64_t span = std::int64_t(1) << (slotBits * numLevels);
+                if ((this->current & (span - 1)) == 0)
+                    this->respread(this->overflow, -1);
+
+                for (int level = numLevels - 1; level > 0; --level) {
+                    int shift = slotBits * level;
+                    if ((this->current & ((std::int64_t(1) << shift) - 1)) != 0)
+                        continue;
+                    this->respread(this->slots[level][(this->current >> shift) & (numSlots - 1)], level);
+                }
+            }
+
+            void respread(TimerEntry*& list, int level)
+            {
+                TimerEntry* entry = list;
+                list = nullptr;
+                while (entry) {
+                    TimerEntry* next = entry->next;
+                    if (level >= 0)
+                        --this->levelCount[level];
+                    this->place(entry);
+                    entry = next;
+                }
+            }
+
+            static void release(TimerEntry*& list)
+            {
+                while (list) {
+                    TimerEntry* entry = list;
+                    list = entry->next;
+                    int status = TimerState::Pending;
+                    entry->state->status.compare_exchange_strong(status, TimerState::Cancelled);
+                    delete entry;
+                }
+            }
+
+            TimerEntry* slots[numLevels][numSlots] = {}; // Slot lists of every level /    
+            size_t levelCount[numLevels] = {};           // Timers on every level /    
+            TimerEntry* overflow = nullptr;              // Timers beyond the last level /    
+            std::int64_t current;                        // Last processed tick /   
+            size_t count = 0;                            // Pending timers /  
+        };
+    }
+
+    /**
+     * @brief Handle of a timer returned by pushAfter(), pushAt() and pushEvery()
+     * @brief  ,  pushAfter(), pushAt()  pushEvery()
+     *
+     * Copies refer to the same timer. Dropping the handle does not cancel it.
+     *     .     .
+     */
+    class TimerHandle
+    {
+    public:
+        TimerHandle() = default;
+        explicit TimerHandle(std::shared_ptr<component::TimerState> state) : state(std::move(state)) {}
+
+        /**
+         * @brief Cancel the timer
+         * @brief  
+         *
+         * A run that has already been handed to the queue still happens.
+         * ,    ,   .
+         *
+         * @return true if a future run was prevented / true     
+         */
+        bool cancel()
+        {
+            if (!this->state)
+                return false;
+            int status = component::TimerState::Pending;
+            return this->state->status.compare_exchange_strong(status, component::TimerState::Cancelled);
+        }
+
+        /**
+         * @brief Check if the timer will still run
+         * @brief ,     
+         */
+        bool isPending() const
+        {
+            return this->state && this->state->status.load() == component::TimerState::Pending;
+        }
+
+    private:
+        std::shared_ptr<component::TimerState> state; // Shared status, nullptr for an empty handle /  , nullptr   
+    };
+}
+
+#endif // TIMER_WHEEL_H
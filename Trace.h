@@ -0,0 +1,316 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include "Metrics.h"
+
+namespace tp
+{
+    /**
+     * @brief Kind of a trace event
+     * @brief   
+     */
+    enum class TraceEvent : std::uint32_t
+    {
+        Push,    // A task was queued /    
+        Dequeue, // A worker looks for its next task /    
+        Begin,   // A task starts /  
+        End,     // A task has finished /  
+        Park,    // A worker goes to sleep /  
+        Unpark   // A worker wakes up /  
+    };
+
+    /**
+     * @brief Label for the tasks pushed by this thread while the object lives
+     * @brief   ,   ,   
+     *
+     * The label is only a pointer, so it must outlive the trace, a string
+     * literal is the usual choice. Scopes nest, the innermost label wins.
+     *
+     *  -   ,     ,
+     *    .  ,  
+     *  .
+     *
+     * @example
+     * {
+     *     tp::TraceLabel label("parse");
+     *     pool.submit(parseChunk, chunk); // Shown as "parse" /   "parse"
+     * }
+     */
+    class TraceLabel
+    {
+    public:
+        explicit TraceLabel(const char* label) : previous(std::exchange(current(), label)) {}
+        ~TraceLabel() { current() = this->previous; }
+
+        TraceLabel(const TraceLabel&) = delete;
+        TraceLabel& operator=(const TraceLabel&) = delete;
+
+        /**
+         * @brief Label of the calling thread, nullptr outside any scope
+         * @brief   , nullptr   
+         */
+        static const char*& current()
+        {
+            static thread_local const char* label = nullptr;
+            return label;
+        }
+
+    private:
+        const char* previous; // Label of the enclosing scope /   
+    };
+
+    namespace component
+    {
+        /**
+         * @brief Small number naming the calling thread in a trace
+         * @brief  ,     
+         *
+         * Workers are traced under their index, other threads get numbers
+         * from firstForeign up.
+         *
+         *      ,  
+         *     firstForeign.
+         */
+        struct TraceThread
+        {
+            static constexpr std::uint32_t firstForeign = 1u << 16;
+
+            static std::uint32_t current()
+            {
+                static std::atomic<std::uint32_t> next{ firstForeign };
+                static thread_local std::uint32_t id = next.fetch_add(1, std::memory_order_relaxed);
+                return id;
+            }
+        };
+
+        /**
+         * @brief Lock-free ring of trace events
+         * @brief    
+         *
+         * Writers claim a slot with one fetch_add, so a worker writing its own
+         * ring never contends and threads outside the pool can share one. Each
+         * slot is a small seqlock: the reader keeps an event only if its
+         * sequence was the same before and after copying it. When the ring
+         * wraps before a flush, the oldest events are lost.
+         *
+         *     fetch_add,  , 
+         *  ,   ,      
+         *  .   -  seqlock:  
+         * ,         . 
+         *    ,    .
+         */
+        class TraceRing
+        {
+        public:
+            /**
+             * @brief Copy of one event
+             * @brief   
+             */
+            struct Record
+            {
+                std::uint64_t time;   // Monotonic time, ns /  , 
+                const char* label;    // Task label or nullptr /    nullptr
+                std::uint32_t thread; // Worker index or foreign thread number /       
+                TraceEvent event;     // Kind of the event /  
+            };
+
+            explicit TraceRing(size_t capacity) : slots(roundUp(capacity)), mask(slots.size() - 1) {}
+
+            void add(TraceEvent event, std::uint32_t thread, const char* label)
+            {
+                std::uint64_t index = this->head.fetch_add(1, std::memory_order_relaxed);
+                Slot& slot = this->slots[index & this->mask];
+
+                slot.sequence.store(0, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                slot.time.store(metricsNow(), std::memory_order_relaxed);
+                slot.label.store(label, std::memory_order_relaxed);
+                slot.thread.store(thread, std::memory_order_relaxed);
+                slot.event.store(static_cast<std::uint32_t>(event), std::memory_order_relaxed);
+                slot.sequence.store(index + 1, std::memory_order_release);
+            }
+
+            /**
+             * @brief Move the events written since the last call to out
+             * @brief   out ,    
+             *
+             * Only one reader at a time. Stops at an event still being written,
+             * the next call picks it up.
+             *     .   , 
+             *  ,    .
+             */
+            void drain(std::vector<Record>& out)
+            {
+                std::uint64_t end = this->head.load(std::memory_order_acquire);
+                std::uint64_t index = this->tail;
+                if (end - index > this->slots.size())
+                    index = end - this->slots.size();
+
+                for (; index < end; ++index) {
+                    Slot& slot = this->slots[index & this->mask];
+                    if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+                        break;
+                    Record record;
+                    record.time = slot.time.load(std::memory_order_relaxed);
+                    record.label = slot.label.load(std::memory_order_relaxed);
+                    record.thread = slot.thread.load(std::memory_order_relaxed);
+                    record.event = static_cast<TraceEvent>(slot.event.load(std::memory_order_relaxed));
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (slot.sequence.load(std::memory_order_relaxed) != index + 1)
+                        break;
+                    out.push_back(record);
+                }
+                this->tail = index;
+            }
+
+        private:
+            struct Slot
+            {
+                std::atomic<std::uint64_t> sequence{ 0 }; // Index + 1 once written, 0 while written /  + 1  , 0   
+                std::atomic<std::uint64_t> time{ 0 };
+                std::atomic<const char*> label{ nullptr };
+                std::atomic<std::uint32_t> thread{ 0 };
+                std::atomic<std::uint32_t> event{ 0 };
+            };
+
+            static size_t roundUp(size_t capacity)
+            {
+                size_t size = 16;
+                while (size < capacity)
+                    size <<= 1;
+                return size;
+            }
+
+            std::vector<Slot> slots;                     // Power-of-two ring /     
+            size_t mask;                                 // slots.size() - 1
+            std::atomic<std::uint64_t> head{ 0 };        // Next slot to claim /   
+            std::uint64_t tail = 0;                      // Next slot to read, reader only /   ,  
+        };
+
+        /**
+         * @brief Rings of one tracing run of a pool
+         * @brief     
+         *
+         * Ring i + 1 belongs to worker i, ring 0 takes everybody else,
+         * including workers added after the run started.
+         *
+         *  i + 1   i,  0  
+         * ,  ,    .
+         */
+        class TraceSession
+        {
+        public:
+            TraceSession(size_t numWorkers, size_t capacity) : start(metricsNow()), capacity(capacity)
+            {
+                for (size_t i = 0; i <= numWorkers; ++i)
+                    this->rings.push_back(std::unique_ptr<TraceRing>(new TraceRing(capacity)));
+            }
+
+            size_t ringCapacity() const { return this->capacity; }
+
+            void add(TraceEvent event, int worker, const char* label)
+            {
+                size_t ring = worker >= 0 ? static_cast<size_t>(worker) + 1 : 0;
+                if (ring >= this->rings.size())
+                    ring = 0;
+                std::uint32_t thread = worker >= 0 ? static_cast<std::uint32_t>(worker) : TraceThread::current();
+                this->rings[ring]->add(event, thread, label);
+            }
+
+            /**
+             * @brief Write the events not flushed yet as Chrome trace-event JSON
+             * @brief        JSON Chrome trace-event
+             *
+             * Tasks are B/E slices named by their label, parking is a "park"
+             * slice, pushes and dequeues are instant events. Loads in
+             * chrome://tracing and Perfetto.
+             *
+             *  -   B/E    ,  -  "park",
+             *    -  .  
+             * chrome://tracing  Perfetto.
+             */
+            void write(std::ostream& out)
+            {
+                std::vector<TraceRing::Record> records;
+                for (auto& ring : this->rings)
+                    ring->drain(records);
+
+                std::vector<std::uint32_t> threads;
+                out << "{\"traceEvents\":[";
+                bool isFirst = true;
+                for (const TraceRing::Record& record : records) {
+                    if (std::find(threads.begin(), threads.end(), record.thread) == threads.end())
+                        threads.push_back(record.thread);
+
+                    const char* name = record.label ? record.label : "task";
+                    const char* phase = "i";
+                    switch (record.event) {
+                    case TraceEvent::Push:    name = "push"; break;
+                    case TraceEvent::Dequeue: name = "dequeue"; break;
+                    case TraceEvent::Begin:   phase = "B"; break;
+                    case TraceEvent::End:     phase = "E"; break;
+                    case TraceEvent::Park:    name = "park"; phase = "B"; break;
+                    case TraceEvent::Unpark:  name = "park"; phase = "E"; break;
+                    }
+
+                    out << (isFirst ? "\n" : ",\n") << "{\"name\":";
+                    writeString(out, name);
+                    out << ",\"ph\":\"" << phase << "\",\"pid\":1,\"tid\":" << record.thread << ",\"ts\":";
+                    std::uint64_t ns = record.time > this->start ? record.time - this->start : 0;
+                    out << ns / 1000 << '.' << static_cast<char>('0' + ns / 100 % 10)
+                        << static_cast<char>('0' + ns / 10 % 10) << static_cast<char>('0' + ns % 10);
+                    if (*phase == 'i')
+                        out << ",\"s\":\"t\"";
+                    if (record.event == TraceEvent::Push && record.label) {
+                        out << ",\"args\":{\"label\":";
+                        writeString(out, record.label);
+                        out << '}';
+                    }
+                    out << '}';
+                    isFirst = false;
+                }
+
+                // Thread names for the viewer
+                //    
+                for (std::uint32_t thread : threads) {
+                    out << (isFirst ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread
+                        << ",\"args\":{\"name\":\"" << (thread < TraceThread::firstForeign ? "worker " : "thread ")
+                        << (thread < TraceThread::firstForeign ? thread : thread - TraceThread::firstForeign) << "\"}}";
+                    isFirst = false;
+                }
+                out << "\n]}\n";
+            }
+
+        private:
+            static void writeString(std::ostream& out, const char* text)
+            {
+                static const char hex[] = "0123456789abcdef";
+                out << '"';
+                for (; *text; ++text) {
+                    unsigned char c = static_cast<unsigned char>(*text);
+                    if (c == '"' || c == '\\')
+                        out << '\\' << *text;
+                    else if (c < 0x20)
+                        out << "\\u00" << hex[c >> 4] << hex[c & 15];
+                    else
+                        out << *text;
+                }
+                out << '"';
+            }
+
+            std::uint64_t start;                          // Time the run started, ns /   , 
+            size_t capacity;                              // Events per ring as requested /   ,  
+            std::vector<std::unique_ptr<TraceRing>> rings; // Rings of foreign threads and workers /     
+        };
+    }
+}
+
+#endif // TRACE_H
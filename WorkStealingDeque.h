@@ -0,0 +1,194 @@
+#ifndef WORK_STEALING_DEQUE_H
+#define WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+#include "TaskAllocator.h"
+
+namespace tp
+{
+    namespace component
+    {
+        /**
+         * @brief Chase-Lev work-stealing deque
+         * @brief     Chase-Lev
+         *
+         * The owner thread pushes and pops at the bottom (LIFO), any other
+         * thread may steal from the top (FIFO). Only steal() is safe to call
+         * from a thread that is not the owner.
+         *
+         * -      (LIFO), 
+         *       (FIFO).  ,
+         *   ,    steal().
+         *
+         * @tparam T Type of elements, must be trivially copyable (e.g. a pointer)
+         * @tparam T  ,     (, )
+         */
+        template <typename T>
+        class WorkStealingDeque : public CacheAligned
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque requires a trivially copyable type");
+
+            /**
+             * @brief Circular buffer of atomic slots
+             * @brief    
+             */
+            struct Array
+            {
+                explicit Array(std::int64_t capacity)
+                    : capacity(capacity), mask(capacity - 1), buffer(new std::atomic<T>[capacity])
+                {
+                }
+
+                T get(std::int64_t i) const { return buffer[i & mask].load(std::memory_order_relaxed); }
+                void put(std::int64_t i, T value) { buffer[i & mask].store(value, std::memory_order_relaxed); }
+
+                /**
+                 * @brief Create a copy of the array with doubled capacity
+                 * @brief      
+                 */
+                Array* grow(std::int64_t bottom, std::int64_t top) const
+                {
+                    Array* array = new Array(capacity * 2);
+                    for (std::int64_t i = top; i != bottom; ++i)
+                        array->put(i, get(i));
+                    return array;
+                }
+
+                std::int64_t capacity;                    // Capacity (power of two) /  ( )
+                std::int64_t mask;                        // Index mask /  
+                std::unique_ptr<std::atomic<T>[]> buffer; // Slots storage /  
+            };
+
+        public:
+            /**
+             * @brief Constructor
+             * @brief 
+             *
+             * @param capacity Initial capacity, rounded up to a power of two /  ,    
+             */
+            explicit WorkStealingDeque(std::int64_t capacity = 256)
+            {
+                std::int64_t size = 1;
+                while (size < capacity)
+                    size <<= 1;
+
+                Array* array = new Array(size);
+                this->garbage.emplace_back(array);
+                this->array.store(array, std::memory_order_relaxed);
+                this->top.store(0, std::memory_order_relaxed);
+                this->bottom.store(0, std::memory_order_relaxed);
+            }
+
+            WorkStealingDeque(const WorkStealingDeque&) = delete;
+            WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+            /**
+             * @brief Push an element to the bottom (owner only)
+             * @brief    ( )
+             *
+             * @param value Element to push /   
+             */
+            void push(T value)
+            {
+                std::int64_t b = this->bottom.load(std::memory_order_relaxed);
+                std::int64_t t = this->top.load(std::memory_order_acquire);
+                Array* a = this->array.load(std::memory_order_relaxed);
+
+                // Grow the buffer when full, old buffers are kept until destruction
+                //    ,     
+                if (b - t > a->capacity - 1) {
+                    a = a->grow(b, t);
+                    this->garbage.emplace_back(a);
+                    this->array.store(a, std::memory_order_release);
+                }
+
+                a->put(b, value);
+                std::atomic_thread_fence(std::memory_order_release);
+                this->bottom.store(b + 1, std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief Pop an element from the bottom (owner only)
+             * @brief    ( )
+             *
+             * @param value Reference to store popped element /     
+             * @return true if element was popped, false if deque is empty / true   , false   
+             */
+            bool pop(T& value)
+            {
+                std::int64_t b = this->bottom.load(std::memory_order_relaxed) - 1;
+                Array* a = this->array.load(std::memory_order_relaxed);
+                this->bottom.store(b, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                std::int64_t t = this->top.load(std::memory_order_relaxed);
+
+                if (t > b) {
+                    // Deque was empty
+                    //   
+                    this->bottom.store(b + 1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                value = a->get(b);
+                if (t == b) {
+                    // Last element - race with thieves
+                    //   -    
+                    bool isWon = this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                    this->bottom.store(b + 1, std::memory_order_relaxed);
+                    return isWon;
+                }
+                return true;
+            }
+
+            /**
+             * @brief Steal an element from the top (any thread)
+             * @brief    ( )
+             *
+             * @param value Reference to store stolen element /     
+             * @return true if element was stolen / true   
+             */
+            bool steal(T& value)
+            {
+                std::int64_t t = this->top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                std::int64_t b = this->bottom.load(std::memory_order_acquire);
+
+                if (t >= b)
+                    return false;
+
+                Array* a = this->array.load(std::memory_order_acquire);
+                T item = a->get(t);
+                if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    return false;
+
+                value = item;
+                return true;
+            }
+
+            /**
+             * @brief Check if the deque is empty
+             * @brief ,   
+             *
+             * @return true if deque is empty (approximate for non-owners) / true    (  -)
+             */
+            bool empty() const
+            {
+                std::int64_t b = this->bottom.load(std::memory_order_relaxed);
+                std::int64_t t = this->top.load(std::memory_order_relaxed);
+                return b <= t;
+            }
+
+        private:
+            alignas(64) std::atomic<std::int64_t> top;    // Steal end index /    
+            alignas(64) std::atomic<std::int64_t> bottom; // Owner end index /   
+            alignas(64) std::atomic<Array*> array;        // Current buffer /  
+            std::vector<std::unique_ptr<Array>> garbage;  // All allocated buffers /   
+        };
+    }
+}
+
+#endif // WORK_STEALING_DEQUE_H
@@ -0,0 +1,306 @@
+﻿#include "ThreadPool.h"
+#include "Parallel.h"
+#include <iostream>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <array>
+#include <future>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// Benchmarks write one CSV row per measurement to stdout:
+//   benchmark,queue,threads,producers,metric,value,unit
+// Run with --quick for a short smoke run. Results of two commits can be
+// compared by joining rows on the first five columns.
+//
+// Бенчмарки выводят одну строку CSV на каждое измерение в stdout:
+//   benchmark,queue,threads,producers,metric,value,unit
+// Запуск с --quick выполняет короткий прогон. Результаты двух коммитов можно
+// сравнить, объединив строки по первым пяти столбцам.
+
+using Clock = std::chrono::steady_clock;
+
+static int numTasks = 200000;  // Tasks per throughput run / Задач на один замер пропускной способности
+static int numSamples = 20000; // Samples per latency run / Замеров на один прогон задержки
+
+/**
+ * @brief Print one result row
+ * @brief Вывод одной строки результата
+ */
+void report(const std::string& benchmark, const std::string& queue, unsigned int threads, unsigned int producers,
+    const std::string& metric, double value, const std::string& unit) {
+    std::cout << benchmark << ',' << queue << ',' << threads << ',' << producers << ','
+        << metric << ',' << value << ',' << unit << std::endl;
+}
+
+/**
+ * @brief Seconds elapsed since start
+ * @brief Секунды, прошедшие с момента start
+ */
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+const char* queue_name(tp::ThreadPool::TypePool type) {
+    switch (type) {
+    case tp::ThreadPool::TypePool::Normal: return "normal";
+    case tp::ThreadPool::TypePool::Priority: return "priority";
+    case tp::ThreadPool::TypePool::WorkStealing: return "workstealing";
+    case tp::ThreadPool::TypePool::LockFree: return "lockfree";
+    case tp::ThreadPool::TypePool::BandedPriority: return "banded";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Wait until counter reaches target, helping the pool meanwhile
+ * @brief Ожидание, пока counter не достигнет target, с помощью пулу
+ */
+template <typename Pool>
+void wait_for(Pool& pool, std::atomic<int>& counter, int target) {
+    while (counter.load(std::memory_order_acquire) < target) {
+        if (!pool.runPendingTask())
+            std::this_thread::yield();
+    }
+}
+
+/**
+ * @brief Empty-task throughput with the given number of producer threads
+ * @brief Пропускная способность пустых задач при заданном числе производителей
+ *
+ * Pool selects the queue at compile time, name overrides the queue column
+ * Pool задает очередь во время компиляции, name заменяет столбец очереди
+ */
+template <typename Pool = tp::ThreadPool>
+void bench_throughput(tp::ThreadPool::TypePool type, unsigned int threads, unsigned int producers, const char* name = nullptr) {
+    Pool pool(threads, type);
+    std::atomic<int> done{ 0 };
+    int perProducer = numTasks / producers;
+    int total = perProducer * producers;
+
+    Clock::time_point start = Clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned int p = 0; p < producers; ++p) {
+        workers.emplace_back([&pool, &done, perProducer]() {
+            for (int i = 0; i < perProducer; ++i)
+                pool.submit([&done](int) { done.fetch_add(1, std::memory_order_release); });
+            });
+    }
+    for (auto& worker : workers)
+        worker.join();
+    double pushTime = seconds_since(start);
+
+    wait_for(pool, done, total);
+    double totalTime = seconds_since(start);
+
+    const char* benchmark = producers == 1 ? "push_single_producer" : "push_multi_producer";
+    const char* queue = name ? name : queue_name(type);
+    report(benchmark, queue, threads, producers, "push_rate", total / pushTime, "tasks/s");
+    report(benchmark, queue, threads, producers, "throughput", total / totalTime, "tasks/s");
+}
+
+/**
+ * @brief Throughput of pushBatch() compared to single pushes
+ * @brief Пропускная способность pushBatch() по сравнению с одиночными добавлениями
+ */
+void bench_batch(tp::ThreadPool::TypePool type, unsigned int threads) {
+    tp::ThreadPool pool(threads, type);
+    std::atomic<int> done{ 0 };
+    std::vector<std::function<void(int)>> batch(256, [&done](int) { done.fetch_add(1, std::memory_order_release); });
+    int rounds = numTasks / static_cast<int>(batch.size());
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < rounds; ++i)
+        pool.submitBatch(batch.begin(), batch.end());
+    wait_for(pool, done, rounds * static_cast<int>(batch.size()));
+
+    report("submit_batch", queue_name(type), threads, 1, "throughput", rounds * batch.size() / seconds_since(start), "tasks/s");
+}
+
+/**
+ * @brief push() with a future and a capture too large for the Task buffer
+ * @brief push() с future и захватом, не помещающимся во внутренний буфер Task
+ *
+ * Every task allocates its closure and its shared state, so this measures
+ * the allocator as much as the queue.
+ *
+ * Каждая задача выделяет память для замыкания и общего состояния, поэтому
+ * здесь измеряется аллокатор не меньше, чем очередь.
+ */
+void bench_future(tp::ThreadPool::TypePool type, unsigned int threads) {
+    tp::ThreadPool pool(threads, type);
+    std::array<std::int64_t, 20> payload{};
+    std::vector<std::future<std::int64_t>> futures;
+    futures.reserve(numTasks);
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < numTasks; ++i)
+        futures.push_back(pool.push([payload, i](int) { return payload[0] + i; }));
+    for (auto& future : futures)
+        future.get();
+
+    report("push_future", queue_name(type), threads, 1, "throughput", numTasks / seconds_since(start), "tasks/s");
+}
+
+/**
+ * @brief push_future with pushOrRun(): a saturated pool runs tasks on the producer
+ * @brief push_future с pushOrRun(): насыщенный пул выполняет задачи в производителе
+ */
+void bench_push_or_run(tp::ThreadPool::TypePool type, unsigned int threads) {
+    tp::ThreadPool pool(threads, type);
+    std::array<std::int64_t, 20> payload{};
+    std::vector<std::future<std::int64_t>> futures;
+    futures.reserve(numTasks);
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < numTasks; ++i)
+        futures.push_back(pool.pushOrRun([payload, i](int) { return payload[0] + i; }));
+    for (auto& future : futures)
+        future.get();
+
+    report("push_or_run", queue_name(type), threads, 1, "throughput", numTasks / seconds_since(start), "tasks/s");
+}
+
+/**
+ * @brief Enqueue-to-execute latency percentiles for isolated tasks
+ * @brief Перцентили задержки от добавления до выполнения для одиночных задач
+ */
+void bench_latency(tp::ThreadPool::TypePool type, unsigned int threads) {
+    tp::ThreadPool pool(threads, type);
+    std::vector<std::int64_t> samples(numSamples);
+
+    for (int i = 0; i < numSamples; ++i) {
+        std::atomic<bool> isDone{ false };
+        Clock::time_point pushed = Clock::now();
+        pool.submit([&samples, &isDone, pushed, i](int) {
+            samples[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - pushed).count();
+            isDone.store(true, std::memory_order_release);
+            });
+        while (!isDone.load(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+
+    struct Percentile { double fraction; const char* name; };
+    const Percentile percentiles[] = { { 0.5, "p50" }, { 0.9, "p90" }, { 0.99, "p99" }, { 0.999, "p999" } };
+
+    std::sort(samples.begin(), samples.end());
+    for (const Percentile& p : percentiles) {
+        size_t index = std::min(samples.size() - 1, static_cast<size_t>(p.fraction * samples.size()));
+        report("latency", queue_name(type), threads, 1, p.name, static_cast<double>(samples[index]), "ns");
+    }
+}
+
+/**
+ * @brief parallel_for over a memory-light loop body
+ * @brief parallel_for для тела цикла с малой нагрузкой на память
+ */
+void bench_parallel_for(unsigned int threads) {
+    tp::ThreadPool pool(threads, tp::ThreadPool::TypePool::WorkStealing);
+    const int n = numTasks * 10;
+    std::vector<double> data(n, 1.0);
+
+    Clock::time_point start = Clock::now();
+    tp::parallel_for(pool, 0, n, [&data](int i) { data[i] = data[i] * 1.000001 + 0.5; });
+    double elapsed = seconds_since(start);
+
+    report("parallel_for", queue_name(tp::ThreadPool::TypePool::WorkStealing), threads, 1, "rate", n / elapsed, "items/s");
+}
+
+/**
+ * @brief Cost of growing and shrinking the pool
+ * @brief Стоимость увеличения и уменьшения пула
+ */
+void bench_resize(unsigned int threads) {
+    threads = std::max(2u, threads);
+    tp::ThreadPool pool(1);
+    const int rounds = 20;
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        pool.resize(threads);
+        pool.resize(1);
+    }
+    double elapsed = seconds_since(start);
+
+    report("resize", queue_name(tp::ThreadPool::TypePool::Normal), threads, 1, "round_trip", elapsed / rounds * 1e6, "us");
+}
+
+/**
+ * @brief Cost of starting and stopping a large pool, half of it parked by resize()
+ * @brief Стоимость запуска и остановки большого пула, половина которого усыплена resize()
+ */
+void bench_lifecycle(unsigned int threads) {
+    const int rounds = 10;
+    double startTime = 0;
+    double stopTime = 0;
+
+    for (int i = 0; i < rounds; ++i) {
+        Clock::time_point start = Clock::now();
+        std::unique_ptr<tp::ThreadPool> pool(new tp::ThreadPool(threads));
+        startTime += seconds_since(start);
+
+        pool->resize(threads / 2);
+        start = Clock::now();
+        pool.reset();
+        stopTime += seconds_since(start);
+    }
+
+    report("lifecycle", queue_name(tp::ThreadPool::TypePool::Normal), threads, 1, "start", startTime / rounds * 1e6, "us");
+    report("lifecycle", queue_name(tp::ThreadPool::TypePool::Normal), threads, 1, "stop", stopTime / rounds * 1e6, "us");
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--quick") == 0) {
+            numTasks = 20000;
+            numSamples = 2000;
+        }
+    }
+
+    unsigned int hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int n = 1; n < hardware; n *= 2)
+        threadCounts.push_back(n);
+    threadCounts.push_back(hardware);
+
+    const tp::ThreadPool::TypePool types[] = {
+        tp::ThreadPool::TypePool::Normal,
+        tp::ThreadPool::TypePool::Priority,
+        tp::ThreadPool::TypePool::WorkStealing,
+        tp::ThreadPool::TypePool::LockFree,
+        tp::ThreadPool::TypePool::BandedPriority
+    };
+
+    std::cout << "benchmark,queue,threads,producers,metric,value,unit" << std::endl;
+
+    for (auto type : types) {
+        for (unsigned int threads : threadCounts) {
+            bench_throughput(type, threads, 1);
+            bench_throughput(type, threads, std::max(2u, hardware));
+            bench_batch(type, threads);
+            bench_future(type, threads);
+            bench_push_or_run(type, threads);
+        }
+        bench_latency(type, hardware);
+    }
+
+    // Same queues with compile-time dispatch
+    // Те же очереди со статической диспетчеризацией
+    for (unsigned int threads : threadCounts) {
+        bench_throughput<tp::BasicThreadPool<tp::component::NormalQueue<tp::Task>>>(tp::ThreadPool::TypePool::Normal, threads, 1, "normal_static");
+        bench_throughput<tp::BasicThreadPool<tp::component::RingQueue<tp::Task>>>(tp::ThreadPool::TypePool::LockFree, threads, 1, "lockfree_static");
+    }
+
+    for (unsigned int threads : threadCounts) {
+        bench_parallel_for(threads);
+        bench_resize(threads);
+    }
+    bench_lifecycle(256);
+
+    return 0;
+}
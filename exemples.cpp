@@ -1,10 +1,14 @@
 ﻿#include "ThreadPool.h"
+#include "TaskGraph.h"
+#include "TaskGroup.h"
+#include "Coroutine.h"
 #include <iostream>
 #include <future>
 #include <chrono>
 #include <cmath>
 #include <atomic>
 #include <string>
+#include <sstream>
 
 /**
  * @brief Test function with parameters and return value
@@ -235,6 +239,320 @@ int main() {
 
     pool.stop(true); // Graceful stop / Плавная остановка
 
+    // Test 12: Fire-and-forget tasks with exception handler
+    // Тест 12: Задачи без получения результата с обработчиком исключений
+    std::cout << "\n12. Testing submit with exception handler...\n";
+    std::cout << "12. Тестирование submit с обработчиком исключений...\n";
+
+    tp::ThreadPool submitPool(2);
+    std::atomic<int> handledErrors{ 0 };
+    submitPool.setExceptionHandler([&handledErrors](int id, std::exception_ptr exception) {
+        try {
+            std::rethrow_exception(exception);
+        }
+        catch (const std::exception& e) {
+            std::cout << "Handler caught in thread " << id << ": " << e.what() << std::endl;
+        }
+        ++handledErrors;
+        });
+
+    for (int i = 0; i < 3; ++i) {
+        submitPool.submit(simple_task);
+    }
+    submitPool.submit(task_with_exception);
+    submitPool.stop(true);
+
+    std::cout << "Handled exceptions: " << handledErrors << std::endl;
+    std::cout << "Обработано исключений: " << handledErrors << std::endl;
+
+    // Test 13: Continuations and a task graph on a single worker
+    // Тест 13: Продолжения и граф задач на одном рабочем потоке
+    std::cout << "\n13. Testing continuations and task graph...\n";
+    std::cout << "13. Тестирование продолжений и графа задач...\n";
+
+    tp::ThreadPool graphPool(1);
+    auto chained = tp::spawn(graphPool, complex_calculation, 3.0, 4.0)
+        .then([](int, double product) { return std::sqrt(product * 3.0); });
+    double chainedResult = chained.get();
+    std::cout << "Chained result: " << chainedResult << std::endl;
+
+    tp::TaskGraph graph(graphPool);
+    size_t load = graph.add([](int id) { std::cout << "Thread " << id << " loads data" << std::endl; });
+    size_t left = graph.add([](int id) { std::cout << "Thread " << id << " processes left half" << std::endl; });
+    size_t right = graph.add([](int id) { std::cout << "Thread " << id << " processes right half" << std::endl; });
+    size_t merge = graph.add([](int id) { std::cout << "Thread " << id << " merges results" << std::endl; });
+    graph.precede(load, left);
+    graph.precede(load, right);
+    graph.precede(left, merge);
+    graph.precede(right, merge);
+    graph.run().get();
+
+#ifdef TP_HAS_COROUTINES
+    // Test 14: Coroutines resumed on the pool
+    // Тест 14: Сопрограммы, возобновляемые в пуле
+    std::cout << "\n14. Testing coroutines...\n";
+    std::cout << "14. Тестирование сопрограмм...\n";
+
+    auto square = [&graphPool](double x) -> tp::task<double> {
+        co_await graphPool.schedule(); // Resumed on the worker / Возобновление в рабочем потоке
+        co_return complex_calculation(0, x, x);
+    };
+    auto sumOfSquares = [&square](double a, double b) -> tp::task<double> {
+        co_return co_await square(a) + co_await square(b);
+    };
+    double sum = tp::sync_wait(sumOfSquares(3.0, 4.0));
+    std::cout << "Sum of squares: " << sum << std::endl;
+#endif
+
+    // Test 15: A task waiting for its child on a single worker
+    // Тест 15: Задача, ожидающая дочернюю задачу, на одном рабочем потоке
+    std::cout << "\n15. Testing helping wait...\n";
+    std::cout << "15. Тестирование ожидания с помощью...\n";
+
+    auto parent = graphPool.push([&graphPool](int) {
+        auto child = graphPool.push(complex_calculation, 6.0, 7.0);
+        return graphPool.waitFor(std::move(child)); // Runs the child here / Выполняет дочернюю задачу здесь
+        });
+    double parentResult = parent.get();
+    std::cout << "Parent result: " << parentResult << std::endl;
+
+    // Test 16: Delayed and periodic tasks without sleeping workers
+    // Тест 16: Отложенные и периодические задачи без спящих потоков
+    std::cout << "\n16. Testing timers...\n";
+    std::cout << "16. Тестирование таймеров...\n";
+
+    std::promise<void> fired;
+    std::atomic<int> ticks{ 0 };
+    tp::ThreadPool timerPool(1); // Destroyed before the state its timers use / Уничтожается раньше состояния, которое используют таймеры
+    timerPool.pushAfter(std::chrono::milliseconds(20), [&fired](int id) {
+        std::cout << "Thread " << id << " runs the delayed task" << std::endl;
+        fired.set_value();
+        });
+    tp::TimerHandle flush = timerPool.pushEvery(std::chrono::milliseconds(5), [&ticks](int) { ++ticks; });
+    tp::TimerHandle timeout = timerPool.pushAt(std::chrono::steady_clock::now() + std::chrono::seconds(10), [](int) {
+        std::cout << "Timeout must not fire" << std::endl;
+        });
+    timeout.cancel(); // The reply came in time / Ответ пришел вовремя
+    fired.get_future().wait();
+    while (ticks < 3)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    flush.cancel();
+    std::cout << "Periodic runs: at least " << ticks.load() << std::endl;
+
+    // Test 17: Bounded queue that refuses work while it is full
+    // Тест 17: Ограниченная очередь, отказывающая в работе, пока заполнена
+    std::cout << "\n17. Testing bounded queue...\n";
+    std::cout << "17. Тестирование ограниченной очереди...\n";
+
+    tp::ThreadPool::PoolConfig bounded;
+    bounded.countThreads = 1;
+    bounded.maxQueueSize = 2;
+    bounded.overflow = tp::OverflowPolicy::Reject;
+    tp::ThreadPool boundedPool(bounded);
+
+    std::promise<void> started;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    boundedPool.push([&started, released](int) { // Occupies the worker / Занимает рабочий поток
+        started.set_value();
+        released.wait();
+        });
+    started.get_future().wait();
+
+    int accepted = 0;
+    while (boundedPool.trySubmit(simple_task))
+        ++accepted;
+    std::cout << "Accepted while full: " << accepted << std::endl;
+    try {
+        boundedPool.push(simple_task);
+    }
+    catch (const tp::QueueFullError& e) {
+        std::cout << "Rejected as expected: " << e.what() << std::endl;
+    }
+    release.set_value();
+
+    // Test 18: Cancelled tasks are dropped before they run
+    // Тест 18: Отмененные задачи отбрасываются до запуска
+    std::cout << "\n18. Testing cancellation...\n";
+    std::cout << "18. Тестирование отмены...\n";
+
+    tp::ThreadPool cancelPool(1);
+    std::promise<void> resume;
+    std::shared_future<void> resumed = resume.get_future().share();
+    cancelPool.push([resumed](int) { resumed.wait(); }); // Holds the queue back / Задерживает очередь
+
+    const std::uint64_t requestId = 42;
+    std::vector<std::future<double>> parts;
+    for (int i = 0; i < 3; ++i)
+        parts.push_back(cancelPool.push(cancelPool.groupToken(requestId), complex_calculation, i * 1.0, 2.0));
+    cancelPool.cancelGroup(requestId); // The request was abandoned / Запрос был отменен
+    resume.set_value();
+
+    int skipped = 0;
+    for (auto& part : parts) {
+        try {
+            part.get();
+        }
+        catch (const std::future_error&) {
+            ++skipped;
+        }
+    }
+    std::cout << "Skipped parts: " << skipped << std::endl;
+
+    // Test 19: A task group waits for its tasks without a future per task
+    // Тест 19: Группа задач ожидает свои задачи без future на каждую задачу
+    std::cout << "\n19. Testing task group...\n";
+    std::cout << "19. Тестирование группы задач...\n";
+
+    tp::ThreadPool groupPool(3);
+    std::atomic<int> processed{ 0 };
+    tp::TaskGroup group(groupPool);
+    for (int i = 0; i < 1000; ++i)
+        group.run([&processed](int) { processed.fetch_add(1, std::memory_order_relaxed); });
+    group.run([](int) { throw std::runtime_error("Task group error"); });
+    try {
+        group.wait();
+    }
+    catch (const std::runtime_error& e) {
+        std::cout << "Caught from group: " << e.what() << std::endl;
+    }
+    std::cout << "Processed in group: " << processed.load() << std::endl;
+
+    // Test 20: waitIdle() separates phases without stopping the pool
+    // Тест 20: waitIdle() разделяет фазы без остановки пула
+    std::cout << "\n20. Testing waitIdle between phases...\n";
+    std::cout << "20. Тестирование waitIdle между фазами...\n";
+
+    tp::ThreadPool phasePool(3);
+    std::atomic<int> phaseDone{ 0 };
+    for (int phase = 0; phase < 3; ++phase) {
+        for (int i = 0; i < 100; ++i)
+            phasePool.submit([&phaseDone](int) { phaseDone.fetch_add(1, std::memory_order_relaxed); });
+        phasePool.waitIdle(); // Barrier between phases / Барьер между фазами
+        std::cout << "Phase " << phase << " finished tasks: " << phaseDone.load() << std::endl;
+    }
+
+    // Test 21: A background lane never takes the worker reserved for the default lane
+    // Тест 21: Фоновая дорожка никогда не занимает поток, зарезервированный для основной дорожки
+    std::cout << "\n21. Testing lanes...\n";
+    std::cout << "21. Тестирование дорожек...\n";
+
+    tp::PoolConfig laneConfig;
+    laneConfig.countThreads = 3;
+    laneConfig.lanes = { { "requests", 4, 1 }, { "background", 1, 0 } };
+    tp::ThreadPool lanePool(laneConfig);
+    size_t background = lanePool.lane("background");
+    std::atomic<int> numBackground{ 0 };
+    std::atomic<int> maxBackground{ 0 };
+    for (int i = 0; i < 50; ++i) {
+        lanePool.submitToLane(background, [&numBackground, &maxBackground](int) {
+            int running = ++numBackground;
+            int seen = maxBackground.load();
+            while (running > seen && !maxBackground.compare_exchange_weak(seen, running)) {}
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            --numBackground;
+            });
+    }
+    std::cout << "Request result: " << lanePool.push([](int) { return 42; }).get() << std::endl;
+    lanePool.waitIdle();
+    std::cout << "Most background tasks at once: " << maxBackground.load() << std::endl;
+
+    // Test 22: pushOrRun() runs a task on the caller while the pool is saturated
+    // Тест 22: pushOrRun() выполняет задачу в вызывающем потоке, пока пул насыщен
+    std::cout << "\n22. Testing pushOrRun...\n";
+    std::cout << "22. Тестирование pushOrRun...\n";
+
+    tp::ThreadPool inlinePool(2);
+    inlinePool.setInlineThreshold(8);
+    std::atomic<bool> isReleased{ false };
+    for (int i = 0; i < 32; ++i) {
+        inlinePool.submit([&isReleased](int) {
+            while (!isReleased.load())
+                std::this_thread::yield();
+            });
+    }
+    while (inlinePool.numIdle() > 0)
+        std::this_thread::yield();
+    auto inlineResult = inlinePool.pushOrRun([](int id) { return id; });
+    std::cout << "Ready before the queue drains: " << (inlineResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready) << std::endl;
+    std::cout << "Run inline with ID: " << inlineResult.get() << std::endl;
+    isReleased = true;
+    inlinePool.waitIdle();
+
+    // Test 23: Tracing records labeled tasks as Chrome trace JSON
+    // Тест 23: Трассировка записывает помеченные задачи в JSON Chrome trace
+    std::cout << "\n23. Testing tracing...\n";
+    std::cout << "23. Тестирование трассировки...\n";
+
+    tp::ThreadPool tracePool(2);
+    tracePool.startTrace();
+    {
+        tp::TraceLabel label("square");
+        for (int i = 0; i < 10; ++i)
+            tracePool.submit([i](int) { return i * i; });
+    }
+    tracePool.waitIdle();
+    tracePool.stopTrace();
+    std::ostringstream trace;
+    tracePool.flushTrace(trace); // Save to a .json file to open in Perfetto / Сохраните в .json файл, чтобы открыть в Perfetto
+    std::string json = trace.str();
+    size_t numSlices = 0;
+    for (size_t pos = json.find("\"name\":\"square\",\"ph\":\"B\""); pos != std::string::npos; pos = json.find("\"name\":\"square\",\"ph\":\"B\"", pos + 1))
+        ++numSlices;
+    std::cout << "Traced \"square\" tasks: " << numSlices << std::endl;
+
+    // Test 24: A large pool starts its workers as a tree and stops with parked workers
+    // Тест 24: Большой пул запускает потоки деревом и останавливается с усыпленными потоками
+    std::cout << "\n24. Testing large pool startup and stop...\n";
+    std::cout << "24. Тестирование запуска и остановки большого пула...\n";
+
+    auto lifeStart = std::chrono::steady_clock::now();
+    {
+        tp::ThreadPool largePool(128);
+        std::atomic<int> largeDone{ 0 };
+        for (int i = 0; i < 1000; ++i)
+            largePool.submit([&largeDone](int) { ++largeDone; });
+        largePool.waitIdle();
+        std::cout << "Workers started: " << largePool.size() << ", tasks done: " << largeDone.load() << std::endl;
+        largePool.resize(8); // 120 workers stay parked until the destructor / 120 потоков остаются усыпленными до деструктора
+    }
+    auto lifeTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - lifeStart);
+    std::cout << "Started and stopped in " << lifeTime.count() << " ms" << std::endl;
+
+    // Test 25: A task blocking on a sibling with future.get() does not hang the pool
+    // Тест 25: Задача, блокирующаяся на соседней через future.get(), не подвешивает пул
+    std::cout << "\n25. Testing a task waiting for a sibling...\n";
+    std::cout << "25. Тестирование задачи, ожидающей соседнюю...\n";
+
+    {
+        tp::ThreadPool pairPool(2);
+        std::atomic<bool> go{ false };
+        for (int i = 0; i < 2; ++i) {
+            pairPool.submit([&go](int) {
+                while (!go.load())
+                    std::this_thread::yield();
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        for (int i = 0; i < 64; ++i)
+            pairPool.submit([](int) {});
+
+        // Both tasks of a pair may land in one batch / Обе задачи пары могут попасть в один пакет
+        const int numPairs = 200;
+        std::vector<std::promise<int>> promises(numPairs);
+        std::vector<std::future<int>> waiters;
+        for (int i = 0; i < numPairs; ++i) {
+            std::shared_future<int> sibling = promises[i].get_future().share();
+            waiters.push_back(pairPool.push([sibling](int) { return sibling.get(); }));
+            pairPool.submit([&promises, i](int) { promises[i].set_value(i); });
+        }
+        go = true;
+        int pairSum = 0;
+        for (auto& waiter : waiters)
+            pairSum += waiter.get();
+        std::cout << "Pairs done: " << waiters.size() << ", sum: " << pairSum << std::endl;
+    }
+
     std::cout << "\n=== ALL TESTS COMPLETED SUCCESSFULLY ===\n";
     std::cout << "=== ВСЕ ТЕСТЫ УСПЕШНО ЗАВЕРШЕНЫ ===\n";
 